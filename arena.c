@@ -0,0 +1,128 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+static const size_t chunk_size = 64 * 1024; // size of the first chunk (later chunks double up to a limit).
+static const size_t max_chunk_size = 16 * 1024 * 1024;
+
+/*
+ * Rounds the size up to a multiple of the alignment.
+ */
+static inline size_t arena_round(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/*
+ * Rounds the size of a block up to its size class and returns the class (ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES if
+ * the block is too large to be recycled). Small blocks have one class per multiple of the alignment and large blocks
+ * one class per power of two.
+ */
+static inline size_t arena_size_class(size_t* size)
+{
+    size_t rounded = arena_round(*size == 0 ? 1 : *size);
+    *size = rounded;
+    if (rounded <= ARENA_SIZE_CLASSES * ARENA_ALIGNMENT) { return rounded / ARENA_ALIGNMENT - 1; }
+
+    size_t power = 2 * ARENA_SIZE_CLASSES * ARENA_ALIGNMENT;
+    size_t size_class = ARENA_SIZE_CLASSES;
+    while (power < rounded && size_class < ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES)
+    {
+        power *= 2;
+        ++size_class;
+    }
+
+    if (size_class < ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES) { *size = power; }
+    return size_class;
+}
+
+/*
+ * Creates an empty arena (chunks are allocated on demand).
+ */
+arena* arena_create()
+{
+    return (arena*)calloc(1, sizeof(arena));
+}
+
+/*
+ * Frees the arena and every block allocated from it. Takes time proportional to the number of chunks, which grow
+ * geometrically, not to the number of allocations.
+ */
+void arena_free(arena* arena)
+{
+    if (arena != NULL)
+    {
+        arena_chunk* chunk = arena->chunks;
+        while (chunk != NULL)
+        {
+            arena_chunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+
+        free(arena);
+    }
+}
+
+/*
+ * Allocates a block of memory from the arena, reusing a released block of the same size class if there is one.
+ */
+void* arena_alloc(arena* arena, size_t size)
+{
+    size_t size_class = arena_size_class(&size);
+
+    arena->total_bytes += size;
+    arena->live_bytes += size;
+    if (arena->live_bytes > arena->peak_bytes)
+    {
+        arena->peak_bytes = arena->live_bytes;
+    }
+
+    if (size_class < ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES && arena->free_lists[size_class] != NULL)
+    {
+        // Pop a released block from the free list (the first word of a released block links to the next one).
+        void* block = arena->free_lists[size_class];
+        arena->free_lists[size_class] = *(void**)block;
+        return block;
+    }
+
+    const size_t header = arena_round(sizeof(arena_chunk));
+    arena_chunk* chunk = arena->chunks;
+
+    if (chunk == NULL || chunk->used + size > chunk->size)
+    {
+        // Start a new chunk, doubling the chunk size so the number of chunks stays logarithmic.
+        size_t capacity = chunk == NULL ? chunk_size : 2 * chunk->size;
+        if (capacity > max_chunk_size) { capacity = max_chunk_size; }
+        if (capacity < size) { capacity = size; }
+
+        chunk = (arena_chunk*)malloc(header + capacity);
+        chunk->next = arena->chunks;
+        chunk->size = capacity;
+        chunk->used = 0;
+        arena->chunks = chunk;
+        arena->reserved_bytes += header + capacity;
+    }
+
+    void* block = (char*)chunk + header + chunk->used;
+    chunk->used += size;
+    return block;
+}
+
+/*
+ * Releases a block of the given size back to the arena to be recycled by later allocations of the same size class
+ * (blocks beyond the largest class are only reclaimed when the arena is freed).
+ */
+void arena_release(arena* arena, void* block, size_t size)
+{
+    if (block == NULL) { return; }
+
+    size_t size_class = arena_size_class(&size);
+    arena->live_bytes -= size;
+
+    if (size_class < ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES)
+    {
+        *(void**)block = arena->free_lists[size_class];
+        arena->free_lists[size_class] = block;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef THEOREMPROVER_ARENA_H
+#define THEOREMPROVER_ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_SIZE_CLASSES 16 // blocks of up to 16 * ARENA_ALIGNMENT bytes are recycled through free lists.
+#define ARENA_LARGE_CLASSES 20 // larger blocks are rounded up to a power of two (up to 256MB) and recycled too.
+#define ARENA_ALIGNMENT 16
+
+/*
+ * Arena chunk is a contiguous block of memory that allocations are carved from.
+ */
+typedef struct arena_chunk
+{
+    struct arena_chunk* next;
+    size_t size;
+    size_t used;
+} arena_chunk;
+
+/*
+ * Arena (region) allocator: allocations are carved sequentially from large chunks and are all released at once when
+ * the arena is freed. Small blocks released individually are kept on per size class free lists (slabs) and reused by
+ * later allocations of the same size class, so long running proofs do not grow without bound.
+ */
+typedef struct arena
+{
+    arena_chunk* chunks;                     // most recently allocated chunk first.
+    void* free_lists[ARENA_SIZE_CLASSES + ARENA_LARGE_CLASSES]; // released blocks of each size class.
+    size_t total_bytes;                      // bytes handed out over the lifetime of the arena.
+    size_t live_bytes;                       // bytes currently in use (handed out and not released).
+    size_t peak_bytes;                       // maximum of live_bytes.
+    size_t reserved_bytes;                   // bytes obtained from the system for chunks.
+} arena;
+
+arena* arena_create();
+
+void arena_free(arena* arena);
+
+void* arena_alloc(arena* arena, size_t size);
+
+void arena_release(arena* arena, void* block, size_t size);
+
+#endif //THEOREMPROVER_ARENA_H
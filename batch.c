@@ -0,0 +1,643 @@
+#include "batch.h"
+#include "parser.h"
+#include "prover.h"
+#include "cache.h"
+#include "dimacs.h"
+#include "parallel.h"
+#include "symbol_table.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static const size_t io_buffer_size = 1 << 16; // size of the stdio buffers used for input and output.
+
+// verdicts and DIMACS exit codes (those of the SAT competition) indexed by prover result.
+static const char* const valid_verdicts[] = { "not valid", "valid", "unknown" };
+static const char* const satisfiable_verdicts[] = { "not satisfiable", "satisfiable", "unknown" };
+static const char* const equivalent_verdicts[] = { "not equivalent", "equivalent", "unknown" };
+static const char* const dimacs_verdicts[] = { "UNSATISFIABLE", "SATISFIABLE", "UNKNOWN" };
+static const int dimacs_codes[] = { 20, 10, 0 };
+
+/*
+ * Batch totals are the running totals of a batch run, or the counts of a single query before they are added to them.
+ */
+typedef struct batch_totals
+{
+    long formulas;
+    long errors;
+    long unknown;       // queries stopped by a limit.
+    long expansions;
+    long branches;
+    long decisions;
+    long conflicts;
+    size_t peak_bytes;
+    size_t total_bytes;
+    long decided[engine_automatic + 1]; // decided queries by engine (the winners of a portfolio).
+} batch_totals;
+
+/*
+ * Batch slot is an entry of the reorder buffer of a parallel batch run: a line waiting to be checked or being checked
+ * by a worker, or its result line waiting to be written once the lines before it are written.
+ */
+typedef struct batch_slot
+{
+    const char* text;   // the line (in the mapped file, or in the copy of a line read from a stream).
+    size_t length;
+    char* copy;
+    size_t capacity;    // capacity of the copy.
+    char* result;       // the result line written by the worker (empty for a blank line).
+    size_t size;
+    batch_totals totals;
+    bool done;
+} batch_slot;
+
+/*
+ * Batch pool is a fixed set of worker threads that check the lines of a parallel batch run. The lines are numbered in
+ * input order and the line with number n goes to slot n modulo the window, so at most window lines are in flight and
+ * the results are written in input order as soon as the lines before them are done. Only the thread that reads the
+ * input submits lines and writes results, so the totals are not shared.
+ */
+typedef struct batch_pool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t submitted;   // a line was submitted or the input ended.
+    pthread_cond_t finished;    // a line was checked.
+    batch_slot* slots;
+    size_t window;
+    size_t next_submit;         // number of the next line to submit.
+    size_t next_task;           // number of the next line a worker takes.
+    size_t next_write;          // number of the next line to write.
+    bool closed;                // the input has ended.
+    pthread_t* workers;
+    int count;
+} batch_pool;
+
+/*
+ * Batch state holds the options, the reusable line buffer and the running totals of a batch run, and the worker pool of
+ * a parallel run (NULL when the lines are checked one at a time on the calling thread).
+ */
+typedef struct batch_state
+{
+    query_type query;
+    const prover_options* options;
+    bool stats;
+    bool model;
+    FILE* output;
+    char* line;
+    size_t capacity;
+    batch_totals totals;
+    batch_pool* pool;
+} batch_state;
+
+/*
+ * Reads the monotonic clock in seconds.
+ */
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Adds the counts of a query (or of several queries) to the totals.
+ */
+static void batch_totals_add(batch_totals* totals, const batch_totals* counts)
+{
+    totals->formulas += counts->formulas;
+    totals->errors += counts->errors;
+    totals->unknown += counts->unknown;
+    totals->expansions += counts->expansions;
+    totals->branches += counts->branches;
+    totals->decisions += counts->decisions;
+    totals->conflicts += counts->conflicts;
+    totals->total_bytes += counts->total_bytes;
+    if (counts->peak_bytes > totals->peak_bytes) { totals->peak_bytes = counts->peak_bytes; }
+    for (int i = 0; i <= engine_automatic; ++i) { totals->decided[i] += counts->decided[i]; }
+}
+
+/*
+ * Parses a single formula (or the two formulas of an equivalence), runs the selected query and writes one result line
+ * to the output: formula, verdict and wall time. The line is copied into the line buffer, and the counts of the query
+ * are added to the totals. The state is only read, so workers can check lines concurrently with buffers, outputs and
+ * totals of their own.
+ */
+static void batch_check(const batch_state* state, char** line, size_t* capacity, const char* text, size_t length,
+                        FILE* output, batch_totals* totals)
+{
+    // Trim trailing carriage returns and whitespace, and skip blank lines.
+    while (length > 0 && (text[length - 1] == '\r' || text[length - 1] == ' ' || text[length - 1] == '\t'))
+    {
+        --length;
+    }
+
+    if (length == 0) { return; }
+
+    // The parser expects a null-terminated string so the line is copied into the reusable buffer.
+    if (length + 1 > *capacity)
+    {
+        *capacity = 2 * (length + 1);
+        *line = (char*)realloc(*line, *capacity);
+    }
+
+    memcpy(*line, text, length);
+    (*line)[length] = '\0';
+
+    double start = now_seconds();
+    const char* verdict;
+    char count[32];
+    prover_stats stats = { 0, 0, 0, 0, 0, 0, engine_tableau };
+    bool decided = false;
+    prover_model model = { 0, NULL, NULL };
+    formula_factory* factory = factory_create(); // owns the formulas of this query.
+    tree_node* second = NULL;
+    char* separator = state->query == query_equivalent ? strchr(*line, '=') : NULL;
+    if (separator != NULL)
+    {
+        // the two formulas are parsed in place and the separator is put back for the result line.
+        *separator = '\0';
+        second = parse(factory, separator + 1);
+    }
+
+    tree_node* node = parse(factory, *line);
+    if (separator != NULL) { *separator = '='; }
+
+    bool parsed = node != NULL && (state->query != query_equivalent || second != NULL);
+    if (!parsed)
+    {
+        verdict = "not a propositional formula";
+        ++totals->errors;
+    }
+    else if (state->query == query_valid)
+    {
+        prover_result valid = state->model ? falsifying_model(factory, node, state->options, &model, &stats)
+                                           : is_valid(factory, node, state->options, &stats);
+        if (state->model && valid != result_unknown)
+        {
+            valid = valid == result_true ? result_false : result_true; // a counterexample exists iff not valid.
+        }
+
+        verdict = valid_verdicts[valid];
+        decided = valid != result_unknown;
+        if (!decided) { ++totals->unknown; }
+    }
+    else if (state->query == query_equivalent)
+    {
+        prover_result equivalent = are_equivalent(factory, node, second, state->options, &stats);
+        verdict = equivalent_verdicts[equivalent];
+        decided = equivalent != result_unknown;
+        if (!decided) { ++totals->unknown; }
+    }
+    else if (state->query == query_count)
+    {
+        uint64_t models;
+        prover_result satisfiable = count_models(factory, node, state->options, &models, &stats);
+        snprintf(count, sizeof(count), "%llu models", (unsigned long long)models);
+        verdict = satisfiable == result_unknown ? satisfiable_verdicts[result_unknown] : count;
+        decided = satisfiable != result_unknown;
+        if (!decided) { ++totals->unknown; }
+    }
+    else
+    {
+        prover_result satisfiable = state->model ? satisfying_model(factory, node, state->options, &model, &stats)
+                                                 : is_satisfiable(factory, node, state->options, &stats);
+        verdict = satisfiable_verdicts[satisfiable];
+        decided = satisfiable != result_unknown;
+        if (!decided) { ++totals->unknown; }
+    }
+
+    size_t formula_bytes = factory->arena->total_bytes;
+    factory_free(factory);
+
+    double elapsed = now_seconds() - start;
+    ++totals->formulas;
+    if (parsed && decided) { ++totals->decided[stats.engine]; }
+    totals->expansions += stats.expansions;
+    totals->branches += stats.branches;
+    totals->decisions += stats.decisions;
+    totals->conflicts += stats.conflicts;
+    totals->total_bytes += stats.total_bytes + formula_bytes;
+    if (stats.peak_bytes + formula_bytes > totals->peak_bytes)
+    {
+        totals->peak_bytes = stats.peak_bytes + formula_bytes;
+    }
+
+    fprintf(output, "%s\t%s\t%.6f", *line, verdict, elapsed);
+    if (state->stats)
+    {
+        // peak and total bytes include the formula nodes created by the query.
+        // a line that failed to parse was not run by any engine.
+        fprintf(output, "\t%ld\t%zu\t%zu\t%ld\t%ld\t%ld\t%s", stats.expansions, stats.peak_bytes + formula_bytes,
+                stats.total_bytes + formula_bytes, stats.decisions, stats.conflicts, stats.branches,
+                parsed ? prover_engine_name(stats.engine) : "-");
+    }
+
+    if (state->model)
+    {
+        // the model satisfies a satisfiable formula or falsifies a formula that is not valid (empty otherwise).
+        fputc('\t', output);
+        prover_model_print(&model, output);
+        prover_model_free(&model);
+    }
+
+    fputc('\n', output);
+}
+
+/*
+ * Worker thread of the batch pool: takes the lines in input order and checks each into the result buffer of its slot.
+ */
+static void* batch_worker(void* argument)
+{
+    const batch_state* state = (const batch_state*)argument;
+    batch_pool* pool = state->pool;
+    char* line = NULL;
+    size_t capacity = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (pool->next_task == pool->next_submit && !pool->closed)
+        {
+            pthread_cond_wait(&pool->submitted, &pool->lock);
+        }
+
+        if (pool->next_task == pool->next_submit) { break; } // the input has ended and every line is taken.
+
+        size_t task = pool->next_task++;
+        pthread_mutex_unlock(&pool->lock);
+
+        batch_slot* slot = &pool->slots[task % pool->window];
+        FILE* output = open_memstream(&slot->result, &slot->size);
+        batch_check(state, &line, &capacity, slot->text, slot->length, output, &slot->totals);
+        fclose(output);
+
+        pthread_mutex_lock(&pool->lock);
+        slot->done = true;
+        if (task == pool->next_write) { pthread_cond_signal(&pool->finished); }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    free(line);
+    return NULL;
+}
+
+/*
+ * Writes the results of the lines that are done, in input order up to the first line that is not. The lock of the
+ * pool is held on entry and on return, and released while a result is written.
+ */
+static void batch_write_done(batch_state* state)
+{
+    batch_pool* pool = state->pool;
+    while (pool->next_write < pool->next_submit && pool->slots[pool->next_write % pool->window].done)
+    {
+        // A done slot is not touched by the workers until it is submitted again.
+        batch_slot* slot = &pool->slots[pool->next_write % pool->window];
+        pthread_mutex_unlock(&pool->lock);
+        fwrite(slot->result, 1, slot->size, state->output);
+        free(slot->result);
+        slot->result = NULL;
+        batch_totals_add(&state->totals, &slot->totals);
+        pthread_mutex_lock(&pool->lock);
+        ++pool->next_write;
+    }
+}
+
+/*
+ * Checks a line: on the calling thread, or by submitting it to the pool once the reorder buffer has a free slot. A
+ * line read from a stream is copied, since the stream reuses its buffer; a mapped line stays valid until the end.
+ */
+static void batch_submit(batch_state* state, const char* text, size_t length, bool copy)
+{
+    batch_pool* pool = state->pool;
+    if (pool == NULL)
+    {
+        batch_check(state, &state->line, &state->capacity, text, length, state->output, &state->totals);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    batch_write_done(state);
+    while (pool->next_submit - pool->next_write == pool->window)
+    {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+        batch_write_done(state);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    // The slot is free and no worker takes it before the line is submitted.
+    batch_slot* slot = &pool->slots[pool->next_submit % pool->window];
+    if (copy)
+    {
+        if (length + 1 > slot->capacity)
+        {
+            slot->capacity = 2 * (length + 1);
+            slot->copy = (char*)realloc(slot->copy, slot->capacity);
+        }
+
+        memcpy(slot->copy, text, length);
+        text = slot->copy;
+    }
+
+    slot->text = text;
+    slot->length = length;
+    slot->done = false;
+    memset(&slot->totals, 0, sizeof(batch_totals));
+
+    pthread_mutex_lock(&pool->lock);
+    ++pool->next_submit;
+    pthread_cond_signal(&pool->submitted);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Starts the worker pool of a parallel batch run with a reorder buffer of a few lines per worker, returning false if
+ * no worker thread could be created (the lines are then checked on the calling thread).
+ */
+static bool batch_pool_start(batch_state* state, batch_pool* pool, int workers)
+{
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->submitted, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pool->window = 16 * (size_t)workers;
+    pool->slots = (batch_slot*)calloc(pool->window, sizeof(batch_slot));
+    pool->next_submit = 0;
+    pool->next_task = 0;
+    pool->next_write = 0;
+    pool->closed = false;
+    pool->workers = (pthread_t*)malloc((size_t)workers * sizeof(pthread_t));
+    pool->count = 0;
+    state->pool = pool;
+
+    while (pool->count < workers &&
+           pthread_create(&pool->workers[pool->count], NULL, batch_worker, state) == 0)
+    {
+        ++pool->count;
+    }
+
+    if (pool->count > 0) { return true; }
+
+    state->pool = NULL;
+    free(pool->workers);
+    free(pool->slots);
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->submitted);
+    pthread_mutex_destroy(&pool->lock);
+    return false;
+}
+
+/*
+ * Ends the input of the worker pool, writes the remaining results in order and joins the workers.
+ */
+static void batch_pool_finish(batch_state* state)
+{
+    batch_pool* pool = state->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->closed = true;
+    pthread_cond_broadcast(&pool->submitted);
+    batch_write_done(state);
+    while (pool->next_write < pool->next_submit)
+    {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+        batch_write_done(state);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->count; ++i) { pthread_join(pool->workers[i], NULL); }
+    for (size_t i = 0; i < pool->window; ++i) { free(pool->slots[i].copy); }
+
+    state->pool = NULL;
+    free(pool->workers);
+    free(pool->slots);
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->submitted);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/*
+ * Checks every line of a memory mapped file.
+ */
+static void batch_check_mapped(batch_state* state, const char* data, size_t size)
+{
+    size_t offset = 0;
+
+    while (offset < size)
+    {
+        const char* line = data + offset;
+        const char* newline = (const char*)memchr(line, '\n', size - offset);
+        size_t length = newline != NULL ? (size_t)(newline - line) : size - offset;
+
+        batch_submit(state, line, length, false);
+        offset += length + 1;
+    }
+}
+
+/*
+ * Checks every line read from a buffered stream.
+ */
+static void batch_check_stream(batch_state* state, FILE* input)
+{
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    setvbuf(input, NULL, _IOFBF, io_buffer_size);
+
+    while ((length = getline(&line, &capacity, input)) != -1)
+    {
+        if (length > 0 && line[length - 1] == '\n') { --length; }
+        batch_submit(state, line, (size_t)length, true);
+    }
+
+    free(line);
+}
+
+/*
+ * Runs the query on every formula in the file (one formula per line) or on standard input when the path is NULL or "-".
+ * With more than one job (0 for one per processor) the formulas are parsed and checked concurrently by a pool of that
+ * many worker threads, and the results are still written in input order.
+ * Writes one result line per formula (with the expansions, peak bytes, total bytes, decisions, conflicts, branches and
+ * the engine that decided the query if stats is set, and then the model or counterexample if model is set) followed by
+ * the totals (with the queries decided by each engine of a portfolio), and returns the number of lines that failed to
+ * parse, or -1 if the input could not be opened.
+ */
+int batch_run(const char* path, query_type query, const prover_options* options, bool stats, bool model, int jobs,
+              FILE* output)
+{
+    batch_state state;
+    memset(&state, 0, sizeof(batch_state));
+    state.query = query;
+    state.options = options;
+    state.stats = stats;
+    state.model = model;
+    state.output = output;
+    setvbuf(output, NULL, _IOFBF, io_buffer_size);
+
+    double start = now_seconds();
+
+    batch_pool pool;
+    int workers = parallel_thread_count(jobs);
+    bool parallel = workers > 1 && batch_pool_start(&state, &pool, workers);
+
+    if (path == NULL || strcmp(path, "-") == 0)
+    {
+        batch_check_stream(&state, stdin);
+    }
+    else
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            if (parallel) { batch_pool_finish(&state); }
+            return -1;
+        }
+
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+        {
+            data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        if (data != MAP_FAILED)
+        {
+            madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+            batch_check_mapped(&state, (const char*)data, (size_t)st.st_size);
+            if (parallel) { batch_pool_finish(&state); } // the workers read the lines from the mapping.
+            munmap(data, (size_t)st.st_size);
+            close(fd);
+        }
+        else
+        {
+            // Pipes, devices and empty files cannot be mapped so they are read as a stream.
+            FILE* input = fdopen(fd, "r");
+            batch_check_stream(&state, input);
+            fclose(input);
+        }
+    }
+
+    if (state.pool != NULL) { batch_pool_finish(&state); }
+
+    const batch_totals* totals = &state.totals;
+    double elapsed = now_seconds() - start;
+    fprintf(output, "# %ld formulas, %ld errors, %ld unknown, %.6f s total, %.1f formulas/s\n",
+            totals->formulas, totals->errors, totals->unknown, elapsed,
+            elapsed > 0 ? (double)totals->formulas / elapsed : 0.0);
+    if (stats)
+    {
+        fprintf(output, "# %ld expansions, %ld branches, %zu peak bytes, %zu total bytes, %ld decisions, "
+                "%ld conflicts\n", totals->expansions, totals->branches, totals->peak_bytes, totals->total_bytes,
+                totals->decisions, totals->conflicts);
+    }
+
+    if (options != NULL && options->engine == engine_portfolio)
+    {
+        // the wins of each engine, to tune the portfolio.
+        const char* separator = " ";
+        fputs("# engines:", output);
+        for (int i = 0; i <= engine_automatic; ++i)
+        {
+            if (totals->decided[i] == 0) { continue; }
+            fprintf(output, "%s%s %ld", separator, prover_engine_name((prover_engine)i), totals->decided[i]);
+            separator = ", ";
+        }
+        fputc('\n', output);
+    }
+
+    if (options != NULL && options->cache != NULL)
+    {
+        long hits;
+        long misses;
+        size_t size;
+        result_cache_counters(options->cache, &hits, &misses, &size);
+        fprintf(output, "# cache: %ld hits, %ld misses, %zu entries\n", hits, misses, size);
+    }
+    fflush(output);
+
+    free(state.line);
+    return (int)totals->errors;
+}
+
+/*
+ * Compares DIMACS literals by variable for sorting.
+ */
+static int batch_compare_variables(const void* a, const void* b)
+{
+    long x = labs(*(const long*)a);
+    long y = labs(*(const long*)b);
+    return (x > y) - (x < y);
+}
+
+/*
+ * Writes a model of a DIMACS instance as value lines ("v" followed by literals in increasing order of variable and a
+ * final 0), with ten literals per line. Only the propositions named "x<v>" are DIMACS variables.
+ */
+static void batch_dimacs_model(const prover_model* model, FILE* output)
+{
+    long* literals = (long*)malloc((model->size + 1) * sizeof(long));
+    size_t count = 0;
+
+    for (size_t i = 0; i < model->size; ++i)
+    {
+        const char* name = symbol_name(model->propositions[i]);
+        if (name[0] == 'x') { literals[count++] = model->values[i] ? atol(name + 1) : -atol(name + 1); }
+    }
+
+    qsort(literals, count, sizeof(long), batch_compare_variables);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i % 10 == 0) { fputs(i > 0 ? "\nv" : "v", output); }
+        fprintf(output, " %ld", literals[i]);
+    }
+
+    if (count % 10 == 0) { fputs(count > 0 ? "\nv" : "v", output); }
+    fputs(" 0\n", output);
+    free(literals);
+}
+
+/*
+ * Loads a DIMACS CNF file (or standard input) and checks whether it is satisfiable, reporting the load and solve times
+ * and the values of the variables if it is.
+ * Returns 10 if satisfiable, 20 if unsatisfiable, 0 if a limit was reached or -1 if the input is malformed.
+ */
+int batch_dimacs(const char* path, const prover_options* options, FILE* output)
+{
+    double start = now_seconds();
+    formula_factory* factory = factory_create();
+    long clauses;
+    theory* set = dimacs_load(factory, path, &clauses);
+    if (set == NULL)
+    {
+        factory_free(factory);
+        return -1;
+    }
+
+    double loaded = now_seconds();
+    fprintf(output, "c loaded %ld clauses in %.6f s\n", clauses, loaded - start);
+    fflush(output);
+
+    prover_stats stats;
+    prover_model model;
+    prover_result satisfiable = theory_model(factory, set, options, &model, &stats);
+
+    fprintf(output, "c solved in %.6f s by the %s engine\n", now_seconds() - loaded, prover_engine_name(stats.engine));
+    fprintf(output, "c %ld expansions, %ld branches, %ld decisions, %ld conflicts, %zu peak bytes, %zu total bytes "
+            "(%zu bytes of formulas)\n",
+            stats.expansions, stats.branches, stats.decisions, stats.conflicts, stats.peak_bytes, stats.total_bytes,
+            factory->arena->total_bytes);
+    factory_free(factory);
+    fprintf(output, "s %s\n", dimacs_verdicts[satisfiable]);
+    if (satisfiable == result_true) { batch_dimacs_model(&model, output); }
+    prover_model_free(&model);
+    fflush(output);
+    return dimacs_codes[satisfiable];
+}
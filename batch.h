@@ -0,0 +1,24 @@
+#ifndef THEOREMPROVER_BATCH_H
+#define THEOREMPROVER_BATCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "prover.h"
+
+/*
+ * Query type selects which property of each formula is checked in batch mode.
+ */
+typedef enum query_type
+{
+    query_satisfiable,
+    query_valid,
+    query_count,    // number of models.
+    query_equivalent    // equivalence of the two formulas of a line, separated by '='.
+} query_type;
+
+int batch_run(const char* path, query_type query, const prover_options* options, bool stats, bool model, int jobs,
+              FILE* output);
+
+int batch_dimacs(const char* path, const prover_options* options, FILE* output);
+
+#endif //THEOREMPROVER_BATCH_H
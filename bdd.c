@@ -0,0 +1,651 @@
+#include "bdd.h"
+#include "tree.h"
+#include "tokenizer.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BDD_TERMINAL_LEVEL UINT32_MAX       // level of the terminals, below every variable.
+#define BDD_FREE_LEVEL (UINT32_MAX - 1)     // level of the collected nodes on the free list.
+
+static const size_t initial_capacity = 1 << 12;
+static const size_t initial_threshold = 1 << 16;
+
+static const char* const ordering_names[] = { "appearance", "frequency", "id" };
+
+/*
+ * Parses a variable ordering name, returning false if the name is not an ordering.
+ */
+bool bdd_ordering_parse(const char* name, bdd_ordering* ordering)
+{
+    for (size_t i = 0; i < sizeof(ordering_names) / sizeof(ordering_names[0]); ++i)
+    {
+        if (strcmp(name, ordering_names[i]) == 0)
+        {
+            *ordering = (bdd_ordering)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Gets the name of a variable ordering.
+ */
+const char* bdd_ordering_name(bdd_ordering ordering)
+{
+    return ordering_names[ordering];
+}
+
+/*
+ * Mixes three values into a hash.
+ */
+static inline size_t bdd_hash(uint32_t a, uint32_t b, uint32_t c)
+{
+    uint64_t hash = ((uint64_t)a * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t)b * 0xc2b2ae3d27d4eb4fULL) ^ c;
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+/*
+ * Updates the bytes in use by the manager.
+ */
+static void bdd_update_bytes(bdd_manager* manager)
+{
+    manager->bytes = manager->capacity * (sizeof(bdd_node) + sizeof(uint32_t)) +
+                     (manager->computed_mask + 1) * sizeof(bdd_computed) +
+                     manager->level_capacity * sizeof(uint32_t) + manager->variables * sizeof(int);
+}
+
+/*
+ * Creates an empty manager with a variable ordering heuristic for the propositions it will meet.
+ */
+bdd_manager* bdd_manager_create(bdd_ordering ordering)
+{
+    bdd_manager* manager = (bdd_manager*)malloc(sizeof(bdd_manager));
+    pthread_mutex_init(&manager->lock, NULL);
+    manager->ordering = ordering;
+    manager->capacity = initial_capacity;
+    manager->nodes = (bdd_node*)malloc(manager->capacity * sizeof(bdd_node));
+    manager->buckets = (uint32_t*)calloc(manager->capacity, sizeof(uint32_t));
+    manager->mask = manager->capacity - 1;
+    manager->computed = (bdd_computed*)calloc(manager->capacity, sizeof(bdd_computed));
+    manager->computed_mask = manager->capacity - 1;
+    manager->threshold = initial_threshold;
+    manager->levels = NULL;
+    manager->level_capacity = 0;
+    manager->propositions = NULL;
+    manager->variables = 0;
+    manager->budget = NULL;
+    manager->work = 0;
+    manager->stopped = false;
+    manager->collections = 0;
+
+    // The terminals are permanent: they are never collected and never in the unique table.
+    for (bdd f = BDD_FALSE; f <= BDD_TRUE; ++f)
+    {
+        bdd_node* node = &manager->nodes[f];
+        node->level = BDD_TERMINAL_LEVEL;
+        node->low = node->high = f;
+        node->next = 0;
+        node->references = 1;
+    }
+
+    manager->size = 2;
+    manager->live = 2;
+    manager->free = 0;
+    bdd_update_bytes(manager);
+    return manager;
+}
+
+/*
+ * Frees a manager and all of its BDDs.
+ */
+void bdd_manager_free(bdd_manager* manager)
+{
+    pthread_mutex_destroy(&manager->lock);
+    free(manager->nodes);
+    free(manager->buckets);
+    free(manager->computed);
+    free(manager->levels);
+    free(manager->propositions);
+    free(manager);
+}
+
+/*
+ * Locks the manager for a query that runs within a budget (none if NULL). Operations stop once the budget is
+ * exhausted, leaving stopped set and returning meaningless (but valid) BDDs until the query ends.
+ */
+void bdd_begin_query(bdd_manager* manager, budget* budget)
+{
+    pthread_mutex_lock(&manager->lock);
+    manager->budget = budget;
+    manager->work = 0;
+    manager->stopped = false;
+}
+
+/*
+ * Unlocks the manager at the end of a query. The computed cache is cleared after a stopped query, so no result of its
+ * interrupted operations outlives it.
+ */
+void bdd_end_query(bdd_manager* manager)
+{
+    if (manager->stopped) { memset(manager->computed, 0, (manager->computed_mask + 1) * sizeof(bdd_computed)); }
+    manager->budget = NULL;
+    manager->stopped = false;
+    pthread_mutex_unlock(&manager->lock);
+}
+
+/*
+ * Adds an external reference to a BDD, which keeps it (and every node below it) alive across collections, and returns
+ * the BDD.
+ */
+bdd bdd_ref(bdd_manager* manager, bdd f)
+{
+    ++manager->nodes[f].references;
+    return f;
+}
+
+/*
+ * Removes an external reference from a BDD. A BDD without references is collected by the next collection unless it is
+ * reachable from a referenced one.
+ */
+void bdd_deref(bdd_manager* manager, bdd f)
+{
+    --manager->nodes[f].references;
+}
+
+/*
+ * Doubles the nodes of the manager and rehashes the unique table. The computed cache grows with the nodes, and its
+ * entries are dropped (they are only shortcuts).
+ */
+static void bdd_grow(bdd_manager* manager)
+{
+    manager->capacity *= 2;
+    manager->nodes = (bdd_node*)realloc(manager->nodes, manager->capacity * sizeof(bdd_node));
+    free(manager->buckets);
+    manager->buckets = (uint32_t*)calloc(manager->capacity, sizeof(uint32_t));
+    manager->mask = manager->capacity - 1;
+    for (uint32_t i = 2; i < manager->size; ++i)
+    {
+        bdd_node* node = &manager->nodes[i];
+        if (node->level == BDD_FREE_LEVEL) { continue; }
+
+        size_t bucket = bdd_hash(node->level, node->low, node->high) & manager->mask;
+        node->next = manager->buckets[bucket];
+        manager->buckets[bucket] = i;
+    }
+
+    free(manager->computed);
+    manager->computed = (bdd_computed*)calloc(manager->capacity, sizeof(bdd_computed));
+    manager->computed_mask = manager->capacity - 1;
+    bdd_update_bytes(manager);
+}
+
+/*
+ * Gets the node that tests the variable at a level with the given children, creating it if the unique table does not
+ * have it yet. A test whose children are the same BDD is that BDD.
+ */
+static bdd bdd_make(bdd_manager* manager, uint32_t level, bdd low, bdd high)
+{
+    if (low == high) { return low; }
+
+    size_t bucket = bdd_hash(level, low, high) & manager->mask;
+    for (uint32_t i = manager->buckets[bucket]; i != 0; i = manager->nodes[i].next)
+    {
+        bdd_node* node = &manager->nodes[i];
+        if (node->level == level && node->low == low && node->high == high) { return i; }
+    }
+
+    uint32_t index = manager->free;
+    if (index != 0)
+    {
+        manager->free = manager->nodes[index].next;
+    }
+    else
+    {
+        if (manager->size == manager->capacity)
+        {
+            bdd_grow(manager);
+            bucket = bdd_hash(level, low, high) & manager->mask;
+        }
+
+        index = (uint32_t)manager->size++;
+    }
+
+    bdd_node* node = &manager->nodes[index];
+    node->level = level;
+    node->low = low;
+    node->high = high;
+    node->references = 0;
+    node->next = manager->buckets[bucket];
+    manager->buckets[bucket] = index;
+    ++manager->live;
+    return index;
+}
+
+/*
+ * Collects the nodes that are not reachable from a referenced BDD: they are put on the free list for reuse, and the
+ * unique table and the computed cache are rebuilt without them. Only the BDDs that are referenced survive, so callers
+ * must reference the BDDs they still need before a collection.
+ */
+void bdd_collect(bdd_manager* manager)
+{
+    bool* marked = (bool*)calloc(manager->size, sizeof(bool));
+    uint32_t* stack = (uint32_t*)malloc(manager->size * sizeof(uint32_t));
+    size_t top = 0;
+
+    marked[BDD_FALSE] = marked[BDD_TRUE] = true;
+    for (uint32_t i = 2; i < manager->size; ++i)
+    {
+        bdd_node* node = &manager->nodes[i];
+        if (node->level == BDD_FREE_LEVEL || node->references == 0 || marked[i]) { continue; }
+
+        marked[i] = true;
+        stack[top++] = i;
+        while (top > 0)
+        {
+            bdd_node* reached = &manager->nodes[stack[--top]];
+            bdd children[2] = { reached->low, reached->high };
+            for (int j = 0; j < 2; ++j)
+            {
+                if (!marked[children[j]])
+                {
+                    marked[children[j]] = true; // each node is stacked at most once.
+                    stack[top++] = children[j];
+                }
+            }
+        }
+    }
+
+    memset(manager->buckets, 0, (manager->mask + 1) * sizeof(uint32_t));
+    manager->free = 0;
+    manager->live = 2;
+    for (uint32_t i = (uint32_t)manager->size - 1; i >= 2; --i)
+    {
+        bdd_node* node = &manager->nodes[i];
+        if (!marked[i])
+        {
+            node->level = BDD_FREE_LEVEL;
+            node->next = manager->free;
+            manager->free = i;
+            continue;
+        }
+
+        size_t bucket = bdd_hash(node->level, node->low, node->high) & manager->mask;
+        node->next = manager->buckets[bucket];
+        manager->buckets[bucket] = i;
+        ++manager->live;
+    }
+
+    // Entries may name collected nodes. Zeroed entries never match, since operations on terminals are not cached.
+    memset(manager->computed, 0, (manager->computed_mask + 1) * sizeof(bdd_computed));
+    ++manager->collections;
+    free(stack);
+    free(marked);
+}
+
+/*
+ * Collects the unreferenced nodes if the live nodes have reached the collection threshold, and doubles the threshold
+ * if most nodes are still live afterwards (so collections stay rare while the BDDs grow).
+ */
+static void bdd_maybe_collect(bdd_manager* manager)
+{
+    if (manager->live < manager->threshold) { return; }
+
+    bdd_collect(manager);
+    if (manager->live * 2 > manager->threshold) { manager->threshold *= 2; }
+}
+
+/*
+ * Gets the cofactors of a BDD for the variable at a level: its children if it tests that variable, or itself for
+ * both values otherwise (the level is at or above its own).
+ */
+static inline void bdd_cofactors(const bdd_manager* manager, bdd f, uint32_t level, bdd* low, bdd* high)
+{
+    const bdd_node* node = &manager->nodes[f];
+    if (node->level == level)
+    {
+        *low = node->low;
+        *high = node->high;
+    }
+    else
+    {
+        *low = *high = f;
+    }
+}
+
+/*
+ * Computes if f then g else h, the operation every connective reduces to. The cases with a terminal condition or
+ * equal branches are answered directly, and the others split on the top variable of the three BDDs and are memoized.
+ * The recursion is bounded by the number of variables.
+ */
+bdd bdd_ite(bdd_manager* manager, bdd f, bdd g, bdd h)
+{
+    if (f == BDD_TRUE) { return g; }
+    if (f == BDD_FALSE) { return h; }
+    if (f == g) { g = BDD_TRUE; }      // ite(f, f, h) = ite(f, 1, h)
+    if (f == h) { h = BDD_FALSE; }     // ite(f, g, f) = ite(f, g, 0)
+    if (g == h) { return g; }
+    if (g == BDD_TRUE && h == BDD_FALSE) { return f; }
+    if (manager->stopped) { return BDD_FALSE; }
+
+    bdd_computed* entry = &manager->computed[bdd_hash(f, g, h) & manager->computed_mask];
+    if (entry->f == f && entry->g == g && entry->h == h) { return entry->result; }
+
+    ++manager->work;
+    if (manager->budget != NULL && budget_exhausted(manager->budget, manager->work, manager->bytes))
+    {
+        manager->stopped = true;
+        return BDD_FALSE;
+    }
+
+    uint32_t level = manager->nodes[f].level;
+    if (manager->nodes[g].level < level) { level = manager->nodes[g].level; }
+    if (manager->nodes[h].level < level) { level = manager->nodes[h].level; }
+
+    bdd f0, f1, g0, g1, h0, h1;
+    bdd_cofactors(manager, f, level, &f0, &f1);
+    bdd_cofactors(manager, g, level, &g0, &g1);
+    bdd_cofactors(manager, h, level, &h0, &h1);
+
+    bdd high = bdd_ite(manager, f1, g1, h1);
+    bdd low = bdd_ite(manager, f0, g0, h0);
+    // A stopped recursion returns meaningless BDDs, which must neither build nodes nor enter the computed cache.
+    if (manager->stopped) { return BDD_FALSE; }
+    bdd result = bdd_make(manager, level, low, high);
+
+    // The nodes (and so the computed cache) may have grown during the recursion.
+    entry = &manager->computed[bdd_hash(f, g, h) & manager->computed_mask];
+    entry->f = f;
+    entry->g = g;
+    entry->h = h;
+    entry->result = result;
+    return result;
+}
+
+/*
+ * Computes the negation of a BDD.
+ */
+bdd bdd_not(bdd_manager* manager, bdd f)
+{
+    return bdd_ite(manager, f, BDD_FALSE, BDD_TRUE);
+}
+
+/*
+ * Computes the conjunction of two BDDs.
+ */
+bdd bdd_and(bdd_manager* manager, bdd f, bdd g)
+{
+    return bdd_ite(manager, f, g, BDD_FALSE);
+}
+
+/*
+ * Computes the disjunction of two BDDs.
+ */
+bdd bdd_or(bdd_manager* manager, bdd f, bdd g)
+{
+    return bdd_ite(manager, f, BDD_TRUE, g);
+}
+
+/*
+ * Computes the implication of two BDDs.
+ */
+bdd bdd_implies(bdd_manager* manager, bdd f, bdd g)
+{
+    return bdd_ite(manager, f, g, BDD_TRUE);
+}
+
+/*
+ * Gets the level of a proposition, or UINT32_MAX if the manager has not met it yet.
+ */
+static inline uint32_t bdd_level(const bdd_manager* manager, int id)
+{
+    return (size_t)id < manager->level_capacity ? manager->levels[id] : UINT32_MAX;
+}
+
+/*
+ * Places a proposition on the next level below the existing ones.
+ */
+static void bdd_add_level(bdd_manager* manager, int id)
+{
+    if ((size_t)id >= manager->level_capacity)
+    {
+        size_t capacity = (size_t)symbol_count() + 1;
+        if (capacity <= (size_t)id) { capacity = (size_t)id + 1; }
+        manager->levels = (uint32_t*)realloc(manager->levels, capacity * sizeof(uint32_t));
+        for (size_t i = manager->level_capacity; i < capacity; ++i) { manager->levels[i] = UINT32_MAX; }
+        manager->level_capacity = capacity;
+    }
+
+    manager->propositions = (int*)realloc(manager->propositions, (manager->variables + 1) * sizeof(int));
+    manager->levels[id] = (uint32_t)manager->variables;
+    manager->propositions[manager->variables++] = id;
+    bdd_update_bytes(manager);
+}
+
+/*
+ * Proposition rank orders the new propositions of a formula for the ordering heuristics.
+ */
+typedef struct bdd_rank
+{
+    int id;
+    size_t occurrences;
+    size_t appearance;
+} bdd_rank;
+
+/*
+ * Compares ranks by decreasing occurrences and then by appearance.
+ */
+static int bdd_compare_frequency(const void* a, const void* b)
+{
+    const bdd_rank* x = (const bdd_rank*)a;
+    const bdd_rank* y = (const bdd_rank*)b;
+    if (x->occurrences != y->occurrences) { return x->occurrences < y->occurrences ? 1 : -1; }
+    return (x->appearance > y->appearance) - (x->appearance < y->appearance);
+}
+
+/*
+ * Compares ranks by proposition id.
+ */
+static int bdd_compare_id(const void* a, const void* b)
+{
+    int x = ((const bdd_rank*)a)->id;
+    int y = ((const bdd_rank*)b)->id;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Places the propositions of the subformulas (marked by node index) that the manager has not met yet on new levels in
+ * the order of the manager's heuristic. Appearance is the order of a left to right preorder traversal of the formulas,
+ * which is iterative and visits every shared subformula once.
+ */
+static void bdd_order(bdd_manager* manager, tree_node** nodes, size_t capacity, tree_node** formulas, size_t count)
+{
+    size_t* occurrences = (size_t*)calloc(capacity, sizeof(size_t)); // parents of each proposition by node index.
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (nodes[i] == NULL) { continue; }
+
+        if (nodes[i]->left_child != NULL) { ++occurrences[nodes[i]->left_child->index]; }
+        if (nodes[i]->right_child != NULL) { ++occurrences[nodes[i]->right_child->index]; }
+    }
+
+    bdd_rank* ranks = (bdd_rank*)malloc((capacity + 1) * sizeof(bdd_rank));
+    bool* visited = (bool*)calloc(capacity, sizeof(bool));
+    tree_node** stack = (tree_node**)malloc((capacity + 1) * sizeof(tree_node*));
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t top = 0;
+        stack[top++] = formulas[i];
+        while (top > 0)
+        {
+            tree_node* node = stack[--top];
+            if (visited[node->index]) { continue; }
+
+            visited[node->index] = true;
+            if (node->token.type == proposition)
+            {
+                if (bdd_level(manager, node->token.id) == UINT32_MAX)
+                {
+                    ranks[size].id = node->token.id;
+                    ranks[size].occurrences = occurrences[node->index];
+                    ranks[size].appearance = size;
+                    ++size;
+                }
+
+                continue;
+            }
+
+            // The right operand is stacked first, so the left one is visited first.
+            if (node->right_child != NULL && !visited[node->right_child->index]) { stack[top++] = node->right_child; }
+            if (!visited[node->left_child->index]) { stack[top++] = node->left_child; }
+        }
+    }
+
+    if (manager->ordering == bdd_order_frequency) { qsort(ranks, size, sizeof(bdd_rank), bdd_compare_frequency); }
+    else if (manager->ordering == bdd_order_id) { qsort(ranks, size, sizeof(bdd_rank), bdd_compare_id); }
+
+    for (size_t i = 0; i < size; ++i) { bdd_add_level(manager, ranks[i].id); }
+
+    free(stack);
+    free(visited);
+    free(ranks);
+    free(occurrences);
+}
+
+/*
+ * Builds the BDD of the conjunction of formulas, bottom up over their subformulas in node index order (operands
+ * first, without recursion). The BDD of a subformula is referenced until its last parent has been built, so the
+ * unreferenced nodes can be collected between subformulas. Returns the BDD with a reference for the caller.
+ */
+static bdd bdd_convert(bdd_manager* manager, formula_factory* factory, tree_node** formulas, size_t count)
+{
+    size_t capacity = factory->size;
+    tree_node** nodes = (tree_node**)calloc(capacity, sizeof(tree_node*));
+    tree_node** stack = (tree_node**)malloc((capacity + 1) * sizeof(tree_node*));
+    for (size_t i = 0; i < count; ++i) { tree_subformulas(formulas[i], nodes, stack); }
+    free(stack);
+
+    bdd_order(manager, nodes, capacity, formulas, count);
+
+    // The parents of each subformula, where the conjunction of the formulas is a parent of each formula.
+    uint32_t* parents = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (nodes[i] == NULL) { continue; }
+
+        if (nodes[i]->left_child != NULL) { ++parents[nodes[i]->left_child->index]; }
+        if (nodes[i]->right_child != NULL) { ++parents[nodes[i]->right_child->index]; }
+    }
+
+    for (size_t i = 0; i < count; ++i) { ++parents[formulas[i]->index]; }
+
+    bdd* results = (bdd*)malloc((capacity + 1) * sizeof(bdd));
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        tree_node* node = nodes[i];
+        if (node == NULL) { continue; }
+
+        bdd_maybe_collect(manager);
+
+        bdd result;
+        if (node->token.type == proposition)
+        {
+            result = bdd_make(manager, bdd_level(manager, node->token.id), BDD_FALSE, BDD_TRUE);
+        }
+        else if (node->token.type == negation)
+        {
+            result = bdd_not(manager, results[node->left_child->index]);
+        }
+        else
+        {
+            bdd left = results[node->left_child->index];
+            bdd right = results[node->right_child->index];
+            char symbol = node->token.symbol;
+            result = is_and_connective(symbol) ? bdd_and(manager, left, right)
+                                               : (is_or_connective(symbol) ? bdd_or(manager, left, right)
+                                                                           : bdd_implies(manager, left, right));
+        }
+
+        results[i] = bdd_ref(manager, result);
+
+        tree_node* children[2] = { node->left_child, node->right_child };
+        for (int j = 0; j < 2; ++j)
+        {
+            if (children[j] != NULL && --parents[children[j]->index] == 0)
+            {
+                bdd_deref(manager, results[children[j]->index]);
+            }
+        }
+    }
+
+    bdd conjunction = bdd_ref(manager, BDD_TRUE);
+    for (size_t i = 0; i < count; ++i)
+    {
+        bdd_maybe_collect(manager);
+
+        bdd next = bdd_ref(manager, bdd_and(manager, conjunction, results[formulas[i]->index]));
+        bdd_deref(manager, conjunction);
+        conjunction = next;
+        if (--parents[formulas[i]->index] == 0) { bdd_deref(manager, results[formulas[i]->index]); }
+    }
+
+    free(results);
+    free(parents);
+    free(nodes);
+    return conjunction;
+}
+
+/*
+ * Builds the BDD of a formula, placing its new propositions with the ordering heuristic of the manager. Returns the
+ * BDD with a reference for the caller.
+ */
+bdd bdd_from_formula(bdd_manager* manager, formula_factory* factory, tree_node* formula)
+{
+    return bdd_convert(manager, factory, &formula, 1);
+}
+
+/*
+ * Builds the BDD of a theory (the conjunction of its formulas). Returns the BDD with a reference for the caller.
+ */
+bdd bdd_from_theory(bdd_manager* manager, formula_factory* factory, theory* theory)
+{
+    size_t count = 0;
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node)) { ++count; }
+
+    tree_node** formulas = (tree_node**)malloc((count + 1) * sizeof(tree_node*));
+    count = 0;
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node))
+    {
+        formulas[count++] = node->formula;
+    }
+
+    bdd result = bdd_convert(manager, factory, formulas, count);
+    free(formulas);
+    return result;
+}
+
+/*
+ * Stores the values of a model of a BDD in a valuation (indexed by proposition id): the propositions tested on a path
+ * to the true terminal that prefers high branches, while the other propositions keep their values. Returns false if
+ * the BDD has no model.
+ */
+bool bdd_model(const bdd_manager* manager, bdd f, bool* valuation)
+{
+    if (f == BDD_FALSE) { return false; }
+
+    while (f != BDD_TRUE)
+    {
+        const bdd_node* node = &manager->nodes[f];
+        bool value = node->high != BDD_FALSE; // every non-terminal node has a model below one of its children.
+        valuation[manager->propositions[node->level]] = value;
+        f = value ? node->high : node->low;
+    }
+
+    return true;
+}
@@ -0,0 +1,147 @@
+#ifndef THEOREMPROVER_BDD_H
+#define THEOREMPROVER_BDD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "factory.h"
+#include "theory.h"
+#include "budget.h"
+
+/*
+ * A BDD is the index of its root node in the manager. The two terminals come first, so the constant BDDs are 0 and 1.
+ */
+typedef uint32_t bdd;
+
+#define BDD_FALSE ((bdd)0)
+#define BDD_TRUE ((bdd)1)
+
+/*
+ * Variable ordering heuristics, which place the propositions of a formula that are new to the manager below the
+ * levels of the propositions it already has.
+ */
+typedef enum bdd_ordering
+{
+    bdd_order_appearance,   // in order of first appearance from left to right (neighbours in the formula stay close).
+    bdd_order_frequency,    // the propositions that occur in the most subformulas first.
+    bdd_order_id            // in order of proposition id (the order in which the names were first read).
+} bdd_ordering;
+
+/*
+ * BDD node tests the variable at its level: low is the BDD for the variable false and high for the variable true.
+ * Nodes with the same level and children are shared through the unique table, where next chains the nodes of a bucket
+ * (and the free nodes once they are collected).
+ */
+typedef struct bdd_node
+{
+    uint32_t level;
+    bdd low;
+    bdd high;
+    uint32_t next;
+    uint32_t references;    // external references that keep the node alive across collections.
+} bdd_node;
+
+/*
+ * BDD computed entry remembers the result of ite(f, g, h).
+ */
+typedef struct bdd_computed
+{
+    bdd f;
+    bdd g;
+    bdd h;
+    bdd result;
+} bdd_computed;
+
+/*
+ * BDD manager holds reduced ordered BDDs over the propositions of any number of formulas. Nodes are hash-consed in
+ * the unique table, so two BDDs of the manager represent equivalent formulas if and only if they are the same node,
+ * and every operation is an if-then-else whose results are memoized in a direct mapped computed cache. Nodes that are
+ * not reachable from an external reference are collected when the number of nodes reaches a threshold. Proposition
+ * ids are global, so formulas from different factories (a premise set and the queries that follow) share the BDDs of
+ * their common subformulas. The manager is locked, so queries on several threads can share it.
+ */
+typedef struct bdd_manager
+{
+    pthread_mutex_t lock;
+    bdd_ordering ordering;
+    bdd_node* nodes;
+    size_t size;            // number of nodes in use or free (including the terminals).
+    size_t capacity;
+    size_t live;            // number of nodes in use.
+    uint32_t free;          // first free node (0 for none).
+    uint32_t* buckets;      // unique table: first node of each bucket (0 for none).
+    size_t mask;            // number of buckets minus one.
+    bdd_computed* computed;
+    size_t computed_mask;
+    size_t threshold;       // number of live nodes that triggers the next collection.
+    uint32_t* levels;       // level of each proposition id (UINT32_MAX if it has none yet).
+    size_t level_capacity;
+    int* propositions;      // proposition id of each level.
+    size_t variables;       // number of levels.
+    budget* budget;         // limits of the running query (NULL for none).
+    long work;              // computed cache misses of the running query.
+    bool stopped;           // a limit stopped the running query.
+    size_t bytes;           // bytes of the nodes, the unique table and the computed cache.
+    long collections;
+} bdd_manager;
+
+bool bdd_ordering_parse(const char* name, bdd_ordering* ordering);
+
+const char* bdd_ordering_name(bdd_ordering ordering);
+
+bdd_manager* bdd_manager_create(bdd_ordering ordering);
+
+void bdd_manager_free(bdd_manager* manager);
+
+void bdd_begin_query(bdd_manager* manager, budget* budget);
+
+void bdd_end_query(bdd_manager* manager);
+
+bdd bdd_ref(bdd_manager* manager, bdd f);
+
+void bdd_deref(bdd_manager* manager, bdd f);
+
+void bdd_collect(bdd_manager* manager);
+
+bdd bdd_ite(bdd_manager* manager, bdd f, bdd g, bdd h);
+
+bdd bdd_not(bdd_manager* manager, bdd f);
+
+bdd bdd_and(bdd_manager* manager, bdd f, bdd g);
+
+bdd bdd_or(bdd_manager* manager, bdd f, bdd g);
+
+bdd bdd_implies(bdd_manager* manager, bdd f, bdd g);
+
+bdd bdd_from_formula(bdd_manager* manager, formula_factory* factory, tree_node* formula);
+
+bdd bdd_from_theory(bdd_manager* manager, formula_factory* factory, theory* theory);
+
+bool bdd_model(const bdd_manager* manager, bdd f, bool* valuation);
+
+/*
+ * Checks if a BDD has a model (a formula is satisfiable iff its BDD is not the false terminal).
+ */
+static inline bool bdd_satisfiable(bdd f)
+{
+    return f != BDD_FALSE;
+}
+
+/*
+ * Checks if a BDD is true under every valuation.
+ */
+static inline bool bdd_valid(bdd f)
+{
+    return f == BDD_TRUE;
+}
+
+/*
+ * Checks if two BDDs of the same manager are equivalent.
+ */
+static inline bool bdd_equivalent(bdd f, bdd g)
+{
+    return f == g;
+}
+
+#endif //THEOREMPROVER_BDD_H
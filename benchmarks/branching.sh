@@ -0,0 +1,33 @@
+#!/bin/sh
+# Compares the branch counts of the tableau branching rules on benchmarks/branching.txt.
+# usage: benchmarks/branching.sh [path to TheoremProver] [engine]
+# The engine defaults to dfs; the breadth-first tableau needs about a minute for the syntactic rule.
+
+dir=$(dirname "$0")
+prover=${1:-"$dir/../build/TheoremProver"}
+engine=${2:-dfs}
+input="$dir/branching.txt"
+
+if [ ! -x "$prover" ]; then
+    echo "branching.sh: $prover is not an executable, pass the path of TheoremProver" >&2
+    exit 2
+fi
+
+verdicts=""
+printf '%-10s %12s %12s %12s\n' rule branches expansions seconds
+for rule in syntactic semantic variable; do
+    output=$("$prover" --batch sat "$input" --stats --engine "$engine" --branching "$rule") || exit 1
+    # The summary lines are "# N formulas, E errors, U unknown, S s total, ..." and "# X expansions, B branches, ...".
+    echo "$output" | awk -v rule="$rule" '
+        /^# [0-9]+ formulas,/ { seconds = $8 }
+        /^# [0-9]+ expansions,/ { expansions = $2; branches = $4 }
+        END { printf "%-10s %12s %12s %12s\n", rule, branches, expansions, seconds }'
+
+    # Every rule must give the same verdicts, otherwise the counts are not comparable.
+    current=$(echo "$output" | grep -v '^#' | cut -f2)
+    if [ -n "$verdicts" ] && [ "$current" != "$verdicts" ]; then
+        echo "branching.sh: the $rule rule changed a verdict" >&2
+        exit 1
+    fi
+    verdicts=$current
+done
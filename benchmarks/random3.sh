@@ -0,0 +1,40 @@
+#!/bin/sh
+# Runs the CDCL engine on random 3-CNF instances with 3.3 clauses per variable, which are satisfiable and easy for a
+# solver that keeps close to a model, at growing numbers of variables.
+# usage: benchmarks/random3.sh [path to TheoremProver] [timeout in seconds]
+# The instances are generated with a fixed seed, so every run solves the same clauses.
+
+dir=$(dirname "$0")
+prover=${1:-"$dir/../build/TheoremProver"}
+timeout=${2:-60}
+input=$(mktemp) || exit 1
+trap 'rm -f "$input"' EXIT
+
+if [ ! -x "$prover" ]; then
+    echo "random3.sh: $prover is not an executable, pass the path of TheoremProver" >&2
+    exit 2
+fi
+
+printf '%-10s %-14s %12s %12s %12s\n' variables result decisions conflicts seconds
+for variables in 5000 10000 12000 15000 20000 30000; do
+    # Park-Miller generator (exact in double arithmetic), seeded by the number of variables.
+    awk -v n="$variables" 'BEGIN {
+        x = n; m = int(n * 3.3)
+        printf "p cnf %d %d\n", n, m
+        for (c = 0; c < m; ++c) {
+            for (k = 0; k < 3; ++k) {
+                x = (16807 * x) % 2147483647; v = x % n + 1
+                x = (16807 * x) % 2147483647; printf "%d ", (x % 2 ? v : -v)
+            }
+            print 0
+        }
+    }' > "$input"
+
+    # The summary lines are "c solved in S s by ...", "c E expansions, B branches, D decisions, C conflicts, ..." and
+    # "s RESULT", or "s UNKNOWN" when the timeout is reached.
+    "$prover" --engine cdcl --timeout "$timeout" --dimacs "$input" | awk -v n="$variables" '
+        /^c solved in/ { seconds = $4 }
+        /^c [0-9]+ expansions,/ { decisions = $6; conflicts = $8 }
+        /^s / { result = $2 }
+        END { printf "%-10s %-14s %12s %12s %12s\n", n, result, decisions, conflicts, seconds }'
+done
@@ -0,0 +1,162 @@
+#include "branching.h"
+#include "tree.h"
+#include "nnf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const branching_names[] = { "syntactic", "semantic", "variable" };
+
+/*
+ * Parses a branching rule name, returning false if the name is not a branching rule.
+ */
+bool branching_parse(const char* name, branching_kind* kind)
+{
+    for (size_t i = 0; i < sizeof(branching_names) / sizeof(branching_names[0]); ++i)
+    {
+        if (strcmp(name, branching_names[i]) == 0)
+        {
+            *kind = (branching_kind)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Gets the name of a branching rule.
+ */
+const char* branching_name(branching_kind kind)
+{
+    return branching_names[kind];
+}
+
+/*
+ * Initializes the branching rule of a search for the root theory (in negation normal form, with its formulas in the
+ * factory). For the semantic and variable rules the complement of every subformula of the root theory is converted
+ * into negation normal form. The complement of a formula in negation normal form is built from the complements of its
+ * subformulas, and the complement of a complement is the formula itself, so the subformulas of the root theory and
+ * their complements are closed under both operations and cover every formula the search can push.
+ */
+void branching_init(branching* branching, branching_kind kind, formula_factory* factory, theory* root)
+{
+    branching->kind = kind;
+    branching->complements = NULL;
+    branching->count = 0;
+
+    if (kind == branch_syntactic) { return; }
+
+    size_t count = factory->size;
+    tree_node** nodes = theory_subformulas(root, count);
+
+    nnf_converter converter;
+    nnf_init(&converter, factory);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (nodes[i] != NULL) { nnf_convert(&converter, nodes[i], true); }
+    }
+
+    // The conversions have created the complements that were not in the factory yet.
+    branching->count = factory->size;
+    branching->complements = (tree_node**)calloc(branching->count, sizeof(tree_node*));
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (nodes[i] == NULL) { continue; }
+
+        tree_node* complement = nnf_convert(&converter, nodes[i], true);
+        branching->complements[i] = complement;
+        branching->complements[complement->index] = nodes[i];
+    }
+
+    nnf_destroy(&converter);
+    free(nodes);
+}
+
+/*
+ * Frees the complements of a branching rule.
+ */
+void branching_destroy(branching* branching)
+{
+    free(branching->complements);
+    branching->complements = NULL;
+    branching->count = 0;
+}
+
+/*
+ * Gets the complement of a formula in negation normal form.
+ */
+static inline tree_node* branching_complement(const branching* branching, tree_node* formula)
+{
+    return branching->complements[formula->index];
+}
+
+/*
+ * Gets the leftmost literal of a formula in negation normal form.
+ */
+static tree_node* branching_leftmost_literal(tree_node* formula)
+{
+    while (!is_literal(formula)) { formula = formula->left_child; }
+    return formula;
+}
+
+/*
+ * Checks if a formula is a literal whose complement is in the theory.
+ */
+static inline bool branching_false_literal(const branching* branching, theory* set, tree_node* formula)
+{
+    return is_literal(formula) && theory_contains(set, branching_complement(branching, formula));
+}
+
+/*
+ * Expands a beta formula (A v B) that was picked from the theory with the branching rule:
+ *   syntactic branching splits into {A} and {B},
+ *   semantic branching splits into {A} and {-A, B}, so every model of the right branch falsifies A,
+ *   variable branching splits into {p, (A v B)} and {-p, (A v B)} on the leftmost literal p of the beta formula, or
+ *   branches semantically once that literal is in the theory.
+ * With the semantic and variable rules a beta formula with a literal operand that is in the theory is dropped, and a
+ * beta formula with a literal operand whose complement is in the theory is replaced by its other operand, without
+ * branching.
+ */
+void branching_expand(const branching* branching, theory* set, tree_node* beta, branching_split* split)
+{
+    tree_node* left = beta->left_child;
+    tree_node* right = beta->right_child;
+    memset(split, 0, sizeof(*split));
+
+    if (branching->kind == branch_syntactic)
+    {
+        split->left[0] = left;
+        split->right[0] = right;
+        split->branches = true;
+        return;
+    }
+
+    if ((is_literal(left) && theory_contains(set, left)) || (is_literal(right) && theory_contains(set, right)))
+    {
+        return; // the theory already satisfies the beta formula.
+    }
+
+    if (branching_false_literal(branching, set, left) || branching_false_literal(branching, set, right))
+    {
+        split->left[0] = branching_false_literal(branching, set, left) ? right : left;
+        return;
+    }
+
+    tree_node* literal = branching_leftmost_literal(beta);
+    if (branching->kind == branch_variable && !theory_contains(set, literal) &&
+        !theory_contains(set, branching_complement(branching, literal)))
+    {
+        split->left[0] = literal;
+        split->left[1] = beta;
+        split->right[0] = branching_complement(branching, literal);
+        split->right[1] = beta;
+        split->branches = true;
+        return;
+    }
+
+    split->left[0] = left;
+    split->right[0] = branching_complement(branching, left);
+    split->right[1] = right;
+    split->branches = true;
+}
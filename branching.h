@@ -0,0 +1,52 @@
+#ifndef THEOREMPROVER_BRANCHING_H
+#define THEOREMPROVER_BRANCHING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "factory.h"
+#include "theory.h"
+
+/*
+ * Branching rules of the tableau engines for a beta formula (A v B).
+ */
+typedef enum branching_kind
+{
+    branch_syntactic,   // {A} and {B}: the branches may share models, so the same models can be searched twice.
+    branch_semantic,    // {A} and {-A, B}: the branches have no model in common.
+    branch_variable     // {p} and {-p} for a proposition p of the beta formula, which stays on both branches.
+} branching_kind;
+
+/*
+ * Branching is the branching rule of one search. The semantic and variable rules push complements of subformulas,
+ * so the negation normal form of the complement of every formula that can occur in the search is created in the
+ * factory when the branching is initialized (the formulas of a search are never created during the search).
+ */
+typedef struct branching
+{
+    branching_kind kind;
+    tree_node** complements;    // complement of each formula by node index (NULL for syntactic branching).
+    size_t count;               // number of complements.
+} branching;
+
+/*
+ * Branching split is the expansion of a beta formula: the formulas pushed to the left branch and to the right branch
+ * (up to two each, NULL for none). A beta formula that does not branch only has a left branch.
+ */
+typedef struct branching_split
+{
+    tree_node* left[2];
+    tree_node* right[2];
+    bool branches;
+} branching_split;
+
+bool branching_parse(const char* name, branching_kind* kind);
+
+const char* branching_name(branching_kind kind);
+
+void branching_init(branching* branching, branching_kind kind, formula_factory* factory, theory* root);
+
+void branching_destroy(branching* branching);
+
+void branching_expand(const branching* branching, theory* set, tree_node* beta, branching_split* split);
+
+#endif //THEOREMPROVER_BRANCHING_H
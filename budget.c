@@ -0,0 +1,67 @@
+#include "budget.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+static const long clock_interval = 256; // steps between two readings of the clock.
+
+/*
+ * Reads the monotonic clock in seconds.
+ */
+static double budget_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Initializes a budget with the limits (no limit if NULL), starting the clock. The work and byte limits are divided
+ * evenly among a number of shares, for searches that are split among workers with a budget each.
+ */
+void budget_init(budget* budget, const prover_limits* limits, int shares)
+{
+    budget->max_work = LONG_MAX;
+    budget->max_bytes = SIZE_MAX;
+    budget->deadline = 0;
+    budget->countdown = clock_interval;
+    budget->cancel = NULL;
+    budget->exhausted = false;
+
+    if (limits == NULL) { return; }
+
+    budget->cancel = limits->cancel;
+
+    if (limits->max_expansions > 0)
+    {
+        budget->max_work = (limits->max_expansions + shares - 1) / shares;
+    }
+
+    if (limits->max_bytes > 0)
+    {
+        budget->max_bytes = (limits->max_bytes + (size_t)shares - 1) / (size_t)shares;
+    }
+
+    if (limits->max_seconds > 0)
+    {
+        budget->deadline = budget_now() + limits->max_seconds;
+    }
+}
+
+/*
+ * Checks the limits of the budget, reading the clock and the cancel flag if the countdown has run out (the slow path of
+ * budget_exhausted). Once a limit is reached the budget stays exhausted.
+ */
+bool budget_check(budget* budget, long work, size_t bytes)
+{
+    if (budget->countdown <= 0)
+    {
+        budget->countdown = clock_interval;
+        if (budget->deadline > 0 && budget_now() >= budget->deadline) { budget->exhausted = true; }
+        if (budget->cancel != NULL && __atomic_load_n(budget->cancel, __ATOMIC_RELAXED)) { budget->exhausted = true; }
+    }
+
+    if (work >= budget->max_work || bytes > budget->max_bytes) { budget->exhausted = true; }
+    return budget->exhausted;
+}
@@ -0,0 +1,47 @@
+#ifndef THEOREMPROVER_BUDGET_H
+#define THEOREMPROVER_BUDGET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Prover limits bound the resources of one query (a zero field sets no limit).
+ */
+typedef struct prover_limits
+{
+    long max_expansions;    // rule applications of the tableau engines, conflicts of the cdcl engine or blocks of
+                            // valuations of the truth table engine.
+    double max_seconds;     // wall clock time.
+    size_t max_bytes;       // bytes in use by the proof (theories and tableau nodes) or by the clauses.
+    const bool* cancel;     // flag set by another thread to stop the query (NULL for none).
+} prover_limits;
+
+/*
+ * Budget tracks the limits of one search. The search reports its work count and the bytes it has in use before every
+ * step: both are compared inline with their limits and the clock (and the cancel flag) is only read every few hundred
+ * steps, so checking the budget costs a decrement and two comparisons per step.
+ */
+typedef struct budget
+{
+    long max_work;
+    size_t max_bytes;
+    double deadline;        // monotonic clock time at which the search stops (0 for none).
+    long countdown;         // steps left before the clock is read again.
+    const bool* cancel;     // cancel flag of the limits (read with the clock).
+    bool exhausted;         // a limit has been reached (or the search was cancelled).
+} budget;
+
+void budget_init(budget* budget, const prover_limits* limits, int shares);
+
+bool budget_check(budget* budget, long work, size_t bytes);
+
+/*
+ * Checks whether the search has to stop before its next step, given its work count and the bytes it has in use.
+ */
+static inline bool budget_exhausted(budget* budget, long work, size_t bytes)
+{
+    return (--budget->countdown <= 0 || work >= budget->max_work || bytes > budget->max_bytes) &&
+           budget_check(budget, work, bytes);
+}
+
+#endif //THEOREMPROVER_BUDGET_H
@@ -0,0 +1,454 @@
+#include "cache.h"
+#include "tree.h"
+#include "tokenizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Cache tags of the encoded subformulas (a proposition is followed by its id, a negation by the position of its
+ * operand and a binary formula by the positions of its two operands).
+ */
+enum
+{
+    tag_proposition,
+    tag_negation,
+    tag_and,
+    tag_or,
+    tag_implies
+};
+
+/*
+ * Cache entry is the verdict of a formula, with the ids of the true propositions of a satisfying valuation if it has
+ * a model. Entries are chained in their bucket and in the list of entries from the most to the least recently used.
+ */
+struct cache_entry
+{
+    uint64_t hash;
+    uint32_t* words;
+    size_t size;
+    prover_result result;
+    bool has_model;
+    int* model;             // ids of the propositions that are true in the model.
+    size_t model_size;
+    cache_entry* chain;     // next entry of the bucket.
+    cache_entry* newer;
+    cache_entry* older;
+};
+
+/*
+ * Cache frame is a subformula of the depth-first traversal that encodes a key, with its operands either still to be
+ * encoded or already encoded.
+ */
+typedef struct cache_frame
+{
+    tree_node* formula;
+    bool expanded;
+} cache_frame;
+
+/*
+ * Mixes a value into a hash.
+ */
+static inline uint64_t cache_mix(uint64_t hash, uint64_t value)
+{
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0xff51afd7ed558ccdULL;
+}
+
+/*
+ * Gets the tag of a subformula.
+ */
+static int cache_tag(tree_node* formula)
+{
+    if (formula->token.type == proposition) { return tag_proposition; }
+    if (formula->token.type == negation) { return tag_negation; }
+    if (is_and_connective(formula->token.symbol)) { return tag_and; }
+    return is_or_connective(formula->token.symbol) ? tag_or : tag_implies;
+}
+
+/*
+ * Gets the number of words of an encoded subformula from its tag.
+ */
+static inline size_t cache_width(uint32_t tag)
+{
+    return tag == tag_proposition || tag == tag_negation ? 2 : 3;
+}
+
+/*
+ * Gets the operands of a binary subformula in canonical order: the operands of a conjunction or a disjunction are
+ * ordered by hash, the operands of an implication keep their order.
+ */
+static void cache_operands(tree_node* formula, tree_node** canonical, const uint64_t* hashes, tree_node** first,
+                           tree_node** second)
+{
+    *first = canonical[formula->left_child->index];
+    *second = canonical[formula->right_child->index];
+    if (cache_tag(formula) != tag_implies && hashes[(*first)->index] > hashes[(*second)->index])
+    {
+        tree_node* swap = *first;
+        *first = *second;
+        *second = swap;
+    }
+}
+
+/*
+ * Creates the key of a formula of the factory (or of its negation if negated is set).
+ * The subformulas are first visited in increasing node index, where operands come before the formulas that contain
+ * them, to find the representative of each subformula (a double negation is represented by the representative of its
+ * operand) and a hash that does not depend on the order of commutative operands. Then the representatives are
+ * encoded in depth-first postorder with an explicit stack, so arbitrarily deep formulas are encoded without recursion.
+ */
+void cache_key_create(cache_key* key, formula_factory* factory, tree_node* formula, bool negated)
+{
+    size_t count = factory->size;
+    tree_node** nodes = (tree_node**)calloc(count, sizeof(tree_node*));
+    tree_node** stack = (tree_node**)malloc((count + 1) * sizeof(tree_node*));
+    tree_subformulas(formula, nodes, stack);
+    free(stack);
+
+    tree_node** canonical = (tree_node**)calloc(count, sizeof(tree_node*)); // representative by node index.
+    uint64_t* hashes = (uint64_t*)calloc(count, sizeof(uint64_t));
+    for (size_t i = 0; i < count; ++i)
+    {
+        tree_node* node = nodes[i];
+        if (node == NULL) { continue; }
+
+        canonical[i] = node;
+        int tag = cache_tag(node);
+        if (tag == tag_proposition)
+        {
+            hashes[i] = cache_mix(tag_proposition, (uint64_t)node->token.id);
+        }
+        else if (tag == tag_negation)
+        {
+            tree_node* operand = canonical[node->left_child->index];
+            if (operand->token.type == negation)
+            {
+                canonical[i] = canonical[operand->left_child->index]; // --A is represented by A.
+                hashes[i] = hashes[canonical[i]->index];
+            }
+            else
+            {
+                hashes[i] = cache_mix(tag_negation, hashes[operand->index]);
+            }
+        }
+        else
+        {
+            tree_node* first;
+            tree_node* second;
+            cache_operands(node, canonical, hashes, &first, &second);
+            hashes[i] = cache_mix(cache_mix((uint64_t)tag, hashes[first->index]), hashes[second->index]);
+        }
+    }
+
+    // Every subformula is stacked at most once unexpanded by each of its (at most count) parents and once expanded.
+    uint32_t* positions = (uint32_t*)calloc(count, sizeof(uint32_t)); // position + 1 of each encoded subformula.
+    cache_frame* frames = (cache_frame*)malloc((3 * count + 1) * sizeof(cache_frame));
+    key->words = (uint32_t*)malloc((3 * count + 2) * sizeof(uint32_t));
+    key->size = 0;
+    size_t top = 0;
+    size_t last = 0; // first word of the root.
+    uint32_t encoded = 0;
+
+    frames[top++] = (cache_frame){ canonical[formula->index], false };
+    while (top > 0)
+    {
+        cache_frame frame = frames[--top];
+        tree_node* node = frame.formula;
+        if (positions[node->index] != 0) { continue; }
+
+        int tag = cache_tag(node);
+        tree_node* first = NULL;
+        tree_node* second = NULL;
+        if (tag == tag_negation) { first = canonical[node->left_child->index]; }
+        else if (tag != tag_proposition) { cache_operands(node, canonical, hashes, &first, &second); }
+
+        if (!frame.expanded)
+        {
+            // The operands are encoded before the subformula, the first operand first.
+            frames[top++] = (cache_frame){ node, true };
+            if (second != NULL && positions[second->index] == 0) { frames[top++] = (cache_frame){ second, false }; }
+            if (first != NULL && positions[first->index] == 0) { frames[top++] = (cache_frame){ first, false }; }
+            continue;
+        }
+
+        last = key->size;
+        key->words[key->size++] = (uint32_t)tag;
+        if (tag == tag_proposition) { key->words[key->size++] = (uint32_t)node->token.id; }
+        if (first != NULL) { key->words[key->size++] = positions[first->index] - 1; }
+        if (second != NULL) { key->words[key->size++] = positions[second->index] - 1; }
+        positions[node->index] = ++encoded;
+    }
+
+    if (negated && key->words[last] == tag_negation)
+    {
+        key->size = last; // the negation of -A is A, whose encoding is the encoding of -A without its root.
+    }
+    else if (negated)
+    {
+        key->words[key->size++] = tag_negation;
+        key->words[key->size++] = encoded - 1;
+    }
+
+    key->hash = 0;
+    for (size_t i = 0; i < key->size; ++i) { key->hash = cache_mix(key->hash, key->words[i]); }
+
+    free(frames);
+    free(positions);
+    free(hashes);
+    free(canonical);
+    free(nodes);
+}
+
+/*
+ * Frees the words of a key.
+ */
+void cache_key_free(cache_key* key)
+{
+    free(key->words);
+    key->words = NULL;
+    key->size = 0;
+}
+
+/*
+ * Creates an empty cache that holds at most a number of entries (at least one).
+ */
+result_cache* result_cache_create(size_t capacity)
+{
+    result_cache* cache = (result_cache*)malloc(sizeof(result_cache));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->capacity = capacity > 0 ? capacity : 1;
+
+    size_t buckets = 16;
+    while (buckets < cache->capacity) { buckets *= 2; }
+    cache->buckets = (cache_entry**)calloc(buckets, sizeof(cache_entry*));
+    cache->mask = buckets - 1;
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->size = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    return cache;
+}
+
+/*
+ * Frees an entry.
+ */
+static void cache_entry_free(cache_entry* entry)
+{
+    free(entry->words);
+    free(entry->model);
+    free(entry);
+}
+
+/*
+ * Frees the cache and its entries.
+ */
+void result_cache_free(result_cache* cache)
+{
+    cache_entry* entry = cache->newest;
+    while (entry != NULL)
+    {
+        cache_entry* older = entry->older;
+        cache_entry_free(entry);
+        entry = older;
+    }
+
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+/*
+ * Removes an entry from the list of entries by use.
+ */
+static void cache_unlink(result_cache* cache, cache_entry* entry)
+{
+    if (entry->newer != NULL) { entry->newer->older = entry->older; } else { cache->newest = entry->older; }
+    if (entry->older != NULL) { entry->older->newer = entry->newer; } else { cache->oldest = entry->newer; }
+}
+
+/*
+ * Puts an entry at the front of the list of entries by use (the most recently used).
+ */
+static void cache_link(result_cache* cache, cache_entry* entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest != NULL) { cache->newest->newer = entry; } else { cache->oldest = entry; }
+    cache->newest = entry;
+}
+
+/*
+ * Finds the entry of a key (NULL if there is none).
+ */
+static cache_entry* cache_find(result_cache* cache, const cache_key* key)
+{
+    cache_entry* entry = cache->buckets[key->hash & cache->mask];
+    while (entry != NULL && (entry->hash != key->hash || entry->size != key->size ||
+                             memcmp(entry->words, key->words, key->size * sizeof(uint32_t)) != 0))
+    {
+        entry = entry->chain;
+    }
+
+    return entry;
+}
+
+/*
+ * Evicts the least recently used entry.
+ */
+static void cache_evict(result_cache* cache)
+{
+    cache_entry* entry = cache->oldest;
+    cache_unlink(cache, entry);
+
+    cache_entry** link = &cache->buckets[entry->hash & cache->mask];
+    while (*link != entry) { link = &(*link)->chain; }
+    *link = entry->chain;
+
+    cache_entry_free(entry);
+    --cache->size;
+}
+
+/*
+ * Looks up the verdict of a key, returning result_unknown on a miss. If the valuation is not NULL (indexed by
+ * proposition id with every value false) the query needs a model: the propositions of the cached model are set in it,
+ * and a satisfiable entry without a model is a miss.
+ */
+prover_result result_cache_lookup(result_cache* cache, const cache_key* key, bool* valuation)
+{
+    pthread_mutex_lock(&cache->lock);
+
+    prover_result result = result_unknown;
+    cache_entry* entry = cache_find(cache, key);
+    if (entry != NULL && (valuation == NULL || entry->result == result_false || entry->has_model))
+    {
+        result = entry->result;
+        if (valuation != NULL)
+        {
+            for (size_t i = 0; i < entry->model_size; ++i) { valuation[entry->model[i]] = true; }
+        }
+
+        cache_unlink(cache, entry);
+        cache_link(cache, entry);
+        ++cache->hits;
+    }
+    else
+    {
+        ++cache->misses;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+/*
+ * Finds or adds the entry of a key, evicting the least recently used entry if the cache is full, and makes it the
+ * most recently used entry.
+ */
+static cache_entry* cache_touch(result_cache* cache, const cache_key* key)
+{
+    cache_entry* entry = cache_find(cache, key);
+    if (entry != NULL)
+    {
+        cache_unlink(cache, entry);
+        cache_link(cache, entry);
+        return entry;
+    }
+
+    if (cache->size == cache->capacity) { cache_evict(cache); }
+
+    entry = (cache_entry*)calloc(1, sizeof(cache_entry));
+    entry->hash = key->hash;
+    entry->size = key->size;
+    entry->words = (uint32_t*)malloc((key->size + 1) * sizeof(uint32_t));
+    memcpy(entry->words, key->words, key->size * sizeof(uint32_t));
+
+    cache_entry** bucket = &cache->buckets[key->hash & cache->mask];
+    entry->chain = *bucket;
+    *bucket = entry;
+    ++cache->size;
+    cache_link(cache, entry);
+    return entry;
+}
+
+/*
+ * Creates the key of the negation of a key in the same way as cache_key_create: the root negation of a negated key is
+ * removed and a negation is added to any other key.
+ */
+static void cache_key_negate(const cache_key* key, cache_key* negated)
+{
+    size_t last = 0;
+    for (size_t i = 0; i < key->size; i += cache_width(key->words[i])) { last = i; }
+
+    negated->words = (uint32_t*)malloc((key->size + 2) * sizeof(uint32_t));
+    memcpy(negated->words, key->words, key->size * sizeof(uint32_t));
+    negated->size = key->size;
+    if (key->words[last] == tag_negation)
+    {
+        negated->size = last;
+    }
+    else
+    {
+        uint32_t count = 0; // the root is the last of the encoded subformulas.
+        for (size_t i = 0; i < key->size; i += cache_width(key->words[i])) { ++count; }
+        negated->words[negated->size++] = tag_negation;
+        negated->words[negated->size++] = count - 1;
+    }
+
+    negated->hash = 0;
+    for (size_t i = 0; i < negated->size; ++i) { negated->hash = cache_mix(negated->hash, negated->words[i]); }
+}
+
+/*
+ * Stores the verdict of a key (an unknown verdict is not stored), with the model in the valuation if it is not NULL
+ * and the key is satisfiable. Only the propositions of the key are kept from the valuation.
+ * The negation of an unsatisfiable formula is valid, so it is also stored as satisfiable with the model that makes
+ * every proposition false.
+ */
+void result_cache_store(result_cache* cache, const cache_key* key, prover_result satisfiable, const bool* valuation)
+{
+    if (satisfiable == result_unknown) { return; }
+
+    cache_key negated = { NULL, 0, 0 };
+    if (satisfiable == result_false) { cache_key_negate(key, &negated); }
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (negated.words != NULL)
+    {
+        cache_entry* valid = cache_touch(cache, &negated);
+        valid->result = result_true;
+        valid->has_model = true; // an empty model makes every proposition false.
+    }
+
+    cache_entry* entry = cache_touch(cache, key);
+    entry->result = satisfiable;
+    if (satisfiable == result_true && valuation != NULL && !entry->has_model)
+    {
+        // The propositions of the key are the operands of its proposition tags.
+        entry->model = (int*)malloc((key->size / 2 + 1) * sizeof(int));
+        for (size_t i = 0; i < key->size; i += cache_width(key->words[i]))
+        {
+            int id = (int)key->words[i + 1];
+            if (key->words[i] == tag_proposition && valuation[id]) { entry->model[entry->model_size++] = id; }
+        }
+
+        entry->has_model = true;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    cache_key_free(&negated);
+}
+
+/*
+ * Reads the hit and miss counters and the number of entries of the cache.
+ */
+void result_cache_counters(result_cache* cache, long* hits, long* misses, size_t* size)
+{
+    pthread_mutex_lock(&cache->lock);
+    *hits = cache->hits;
+    *misses = cache->misses;
+    *size = cache->size;
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,60 @@
+#ifndef THEOREMPROVER_CACHE_H
+#define THEOREMPROVER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "factory.h"
+#include "prover.h"
+
+/*
+ * Cache key is the canonical encoding of a formula: its distinct subformulas in depth-first postorder, each written
+ * as a tag and its operands (a proposition id, or the positions of the encoded subformulas). The operands of
+ * conjunctions and disjunctions are ordered by a structural hash that does not depend on their order, and double
+ * negations are removed, so formulas that only differ in the order of commutative operands or in double negations
+ * usually get the same key. Proposition ids are global, so keys of formulas from different factories can be compared.
+ */
+typedef struct cache_key
+{
+    uint32_t* words;
+    size_t size;        // number of words.
+    uint64_t hash;      // hash of the words.
+} cache_key;
+
+typedef struct cache_entry cache_entry;
+
+/*
+ * Result cache remembers the satisfiability verdicts of formulas across queries (and factories), with the propositions
+ * of a satisfying valuation when the query asked for one. It holds at most a fixed number of entries and evicts the
+ * least recently used one when it is full. Validity and falsifying models are read from the entry of the negated
+ * formula. The cache is locked, so queries on several threads can share it.
+ */
+struct result_cache
+{
+    pthread_mutex_t lock;
+    cache_entry** buckets;  // chained hash table of the entries by key hash.
+    size_t mask;            // number of buckets minus one (the number of buckets is a power of two).
+    cache_entry* newest;    // most recently used entry.
+    cache_entry* oldest;    // least recently used entry, evicted first.
+    size_t size;            // number of entries.
+    size_t capacity;        // maximum number of entries.
+    long hits;
+    long misses;
+};
+
+void cache_key_create(cache_key* key, formula_factory* factory, tree_node* formula, bool negated);
+
+void cache_key_free(cache_key* key);
+
+result_cache* result_cache_create(size_t capacity);
+
+void result_cache_free(result_cache* cache);
+
+prover_result result_cache_lookup(result_cache* cache, const cache_key* key, bool* valuation);
+
+void result_cache_store(result_cache* cache, const cache_key* key, prover_result satisfiable, const bool* valuation);
+
+void result_cache_counters(result_cache* cache, long* hits, long* misses, size_t* size);
+
+#endif //THEOREMPROVER_CACHE_H
@@ -0,0 +1,1091 @@
+#include "cdcl.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int restart_unit = 100;            // conflicts per restart interval unit (scaled by the Luby sequence).
+static const double variable_decay = 0.95;      // VSIDS decay of the variable activities after each conflict.
+static const double clause_decay = 0.999;       // decay of the learnt clause activities after each conflict.
+static const double min_learnts = 2000;         // learnt clauses allowed before the first reduction (at least).
+static const double learnts_growth = 1.1;       // growth of the learnt clause limit after each reduction.
+static const unsigned int glue_lbd = 2;         // learnt clauses with at most this lbd are never removed.
+static const long walk_effort = 10;             // flips of a local search walk per original clause.
+static const unsigned int walk_noise = 567;     // per mille chance of a random flip when every flip falsifies a clause.
+
+/*
+ * Grows an array to hold at least the needed number of items (doubling the capacity).
+ */
+static void* cdcl_reserve(void* items, size_t* capacity, size_t needed, size_t item_size)
+{
+    if (needed <= *capacity) { return items; }
+
+    size_t grown = *capacity == 0 ? 16 : 2 * *capacity;
+    while (grown < needed) { grown *= 2; }
+    *capacity = grown;
+    return realloc(items, grown * item_size);
+}
+
+/*
+ * Creates an empty solver without variables or clauses.
+ */
+cdcl_solver* cdcl_create()
+{
+    cdcl_solver* solver = (cdcl_solver*)calloc(1, sizeof(cdcl_solver));
+    solver->max_learnts = min_learnts;
+    solver->variable_increment = 1.0;
+    solver->clause_increment = 1.0;
+    solver->random = 0x853c49e6748fea9bULL;
+    solver->level_stamps = (int*)calloc(1, sizeof(int));
+    return solver;
+}
+
+/*
+ * Frees the solver with all of its clauses.
+ */
+void cdcl_free(cdcl_solver* solver)
+{
+    if (solver == NULL) { return; }
+
+    for (size_t i = 0; i < solver->clause_count; ++i) { free(solver->clauses[i]); }
+    for (size_t i = 0; i < solver->learnt_count; ++i) { free(solver->learnts[i]); }
+    for (int i = 0; i < 2 * solver->variables; ++i) { free(solver->watches[i].items); }
+
+    free(solver->values);
+    free(solver->levels);
+    free(solver->reasons);
+    free(solver->phases);
+    free(solver->model);
+    free(solver->seen);
+    free(solver->activity);
+    free(solver->heap);
+    free(solver->heap_index);
+    free(solver->watches);
+    free(solver->trail);
+    free(solver->trail_limits);
+    free(solver->clauses);
+    free(solver->learnts);
+    free(solver->buffer);
+    free(solver->level_stamps);
+    free(solver);
+}
+
+/*
+ * Gets the value of a literal (1 true, -1 false, 0 unassigned).
+ */
+static inline signed char cdcl_value(cdcl_solver* solver, cdcl_literal literal)
+{
+    return solver->values[literal];
+}
+
+/*
+ * Moves the variable at a heap position up while its activity is larger than its parent's.
+ */
+static void heap_up(cdcl_solver* solver, int position)
+{
+    int variable = solver->heap[position];
+    double activity = solver->activity[variable];
+
+    while (position > 0)
+    {
+        int parent = (position - 1) / 2;
+        if (solver->activity[solver->heap[parent]] >= activity) { break; }
+        solver->heap[position] = solver->heap[parent];
+        solver->heap_index[solver->heap[position]] = position;
+        position = parent;
+    }
+
+    solver->heap[position] = variable;
+    solver->heap_index[variable] = position;
+}
+
+/*
+ * Moves the variable at a heap position down while one of its children has a larger activity.
+ */
+static void heap_down(cdcl_solver* solver, int position)
+{
+    int variable = solver->heap[position];
+    double activity = solver->activity[variable];
+
+    while (2 * position + 1 < solver->heap_size)
+    {
+        int child = 2 * position + 1;
+        if (child + 1 < solver->heap_size &&
+            solver->activity[solver->heap[child + 1]] > solver->activity[solver->heap[child]])
+        {
+            ++child;
+        }
+
+        if (solver->activity[solver->heap[child]] <= activity) { break; }
+        solver->heap[position] = solver->heap[child];
+        solver->heap_index[solver->heap[position]] = position;
+        position = child;
+    }
+
+    solver->heap[position] = variable;
+    solver->heap_index[variable] = position;
+}
+
+/*
+ * Inserts a variable into the decision heap if it is not already there.
+ */
+static void heap_insert(cdcl_solver* solver, int variable)
+{
+    if (solver->heap_index[variable] >= 0) { return; }
+
+    solver->heap[solver->heap_size] = variable;
+    solver->heap_index[variable] = solver->heap_size;
+    heap_up(solver, solver->heap_size++);
+}
+
+/*
+ * Removes and returns the variable with the largest activity from the decision heap.
+ */
+static int heap_pop(cdcl_solver* solver)
+{
+    int variable = solver->heap[0];
+    solver->heap_index[variable] = -1;
+
+    if (--solver->heap_size > 0)
+    {
+        solver->heap[0] = solver->heap[solver->heap_size];
+        solver->heap_index[solver->heap[0]] = 0;
+        heap_down(solver, 0);
+    }
+
+    return variable;
+}
+
+/*
+ * Adds a new variable to the solver and returns its index.
+ */
+int cdcl_new_var(cdcl_solver* solver)
+{
+    int variable = solver->variables;
+
+    if (variable == solver->capacity)
+    {
+        int capacity = solver->capacity == 0 ? 64 : 2 * solver->capacity;
+        size_t count = (size_t)capacity;
+
+        solver->values = (signed char*)realloc(solver->values, 2 * count * sizeof(signed char));
+        solver->levels = (int*)realloc(solver->levels, count * sizeof(int));
+        solver->reasons = (cdcl_clause**)realloc(solver->reasons, count * sizeof(cdcl_clause*));
+        solver->phases = (bool*)realloc(solver->phases, count * sizeof(bool));
+        solver->model = (bool*)realloc(solver->model, count * sizeof(bool));
+        solver->seen = (bool*)realloc(solver->seen, count * sizeof(bool));
+        solver->activity = (double*)realloc(solver->activity, count * sizeof(double));
+        solver->heap = (int*)realloc(solver->heap, count * sizeof(int));
+        solver->heap_index = (int*)realloc(solver->heap_index, count * sizeof(int));
+        solver->watches = (cdcl_watch_list*)realloc(solver->watches, 2 * count * sizeof(cdcl_watch_list));
+        solver->trail = (cdcl_literal*)realloc(solver->trail, count * sizeof(cdcl_literal));
+        solver->trail_limits = (int*)realloc(solver->trail_limits, count * sizeof(int));
+        solver->level_stamps = (int*)realloc(solver->level_stamps, (count + 1) * sizeof(int));
+        memset(solver->level_stamps + solver->capacity + 1, 0, (count - (size_t)solver->capacity) * sizeof(int));
+        solver->capacity = capacity;
+    }
+
+    solver->values[cdcl_lit(variable, false)] = 0;
+    solver->values[cdcl_lit(variable, true)] = 0;
+    solver->levels[variable] = 0;
+    solver->reasons[variable] = NULL;
+    solver->phases[variable] = true; // variables are first decided false.
+    solver->model[variable] = false;
+    solver->seen[variable] = false;
+    solver->activity[variable] = 0.0;
+    solver->heap_index[variable] = -1;
+    memset(&solver->watches[cdcl_lit(variable, false)], 0, 2 * sizeof(cdcl_watch_list));
+    solver->variables = variable + 1;
+    heap_insert(solver, variable);
+    return variable;
+}
+
+/*
+ * Assigns a literal true at the current decision level with the clause that implied it (NULL for decisions).
+ */
+static inline void cdcl_assign(cdcl_solver* solver, cdcl_literal literal, cdcl_clause* reason)
+{
+    int variable = cdcl_var(literal);
+    solver->values[literal] = 1;
+    solver->values[cdcl_negate(literal)] = -1;
+    solver->levels[variable] = solver->decision_level;
+    solver->reasons[variable] = reason;
+    solver->trail[solver->trail_size++] = literal;
+}
+
+/*
+ * Adds a watch to the watch list of a literal.
+ */
+static inline void cdcl_watch_push(cdcl_watch_list* list, cdcl_clause* clause, cdcl_literal blocker)
+{
+    if (list->size == list->capacity)
+    {
+        list->items = (cdcl_watch*)cdcl_reserve(list->items, &list->capacity, list->size + 1, sizeof(cdcl_watch));
+    }
+
+    list->items[list->size].clause = clause;
+    list->items[list->size].blocker = blocker;
+    ++list->size;
+}
+
+/*
+ * Allocates a clause and watches its first two literals.
+ */
+static cdcl_clause* cdcl_attach(cdcl_solver* solver, const cdcl_literal* literals, size_t size, bool learnt)
+{
+    size_t bytes = sizeof(cdcl_clause) + size * sizeof(cdcl_literal);
+    cdcl_clause* clause = (cdcl_clause*)malloc(bytes);
+    clause->size = (unsigned int)size;
+    clause->lbd = 0;
+    clause->learnt = learnt;
+    clause->removed = false;
+    clause->activity = 0.0f;
+    memcpy(clause->literals, literals, size * sizeof(cdcl_literal));
+
+    solver->stats.total_bytes += bytes;
+    solver->stats.live_bytes += bytes;
+    if (solver->stats.live_bytes > solver->stats.peak_bytes) { solver->stats.peak_bytes = solver->stats.live_bytes; }
+
+    // A clause is visited when the negation of one of its watched literals is assigned.
+    cdcl_watch_push(&solver->watches[cdcl_negate(literals[0])], clause, literals[1]);
+    cdcl_watch_push(&solver->watches[cdcl_negate(literals[1])], clause, literals[0]);
+
+    if (learnt)
+    {
+        solver->learnts = (cdcl_clause**)cdcl_reserve(solver->learnts, &solver->learnt_capacity,
+                                                      solver->learnt_count + 1, sizeof(cdcl_clause*));
+        solver->learnts[solver->learnt_count++] = clause;
+    }
+    else
+    {
+        solver->clauses = (cdcl_clause**)cdcl_reserve(solver->clauses, &solver->clause_capacity,
+                                                      solver->clause_count + 1, sizeof(cdcl_clause*));
+        solver->clauses[solver->clause_count++] = clause;
+    }
+
+    return clause;
+}
+
+/*
+ * Propagates the assignments on the trail with two watched literals and returns a conflicting clause, or NULL if
+ * every clause is satisfied, unit (its remaining literal is assigned) or has two unassigned literals.
+ */
+static cdcl_clause* cdcl_propagate(cdcl_solver* solver)
+{
+    cdcl_clause* conflict = NULL;
+
+    while (solver->propagated < solver->trail_size)
+    {
+        cdcl_literal assigned = solver->trail[solver->propagated++];
+        cdcl_literal false_literal = cdcl_negate(assigned);
+        cdcl_watch_list* list = &solver->watches[assigned];
+        size_t i = 0;
+        size_t j = 0;
+        ++solver->stats.propagations;
+
+        while (i < list->size)
+        {
+            cdcl_watch watch = list->items[i++];
+            if (cdcl_value(solver, watch.blocker) == 1)
+            {
+                list->items[j++] = watch; // the clause is satisfied by its blocker.
+                continue;
+            }
+
+            // Make sure the false literal is the second watched literal.
+            cdcl_clause* clause = watch.clause;
+            cdcl_literal* literals = clause->literals;
+            if (literals[0] == false_literal)
+            {
+                literals[0] = literals[1];
+                literals[1] = false_literal;
+            }
+
+            // The other watched literal becomes the blocker.
+            cdcl_literal first = literals[0];
+            bool blocked = first != watch.blocker && cdcl_value(solver, first) == 1;
+            watch.blocker = first;
+            if (blocked)
+            {
+                list->items[j++] = watch; // the clause is satisfied by its other watched literal.
+                continue;
+            }
+
+            // Look for a literal that is not false to watch instead.
+            bool moved = false;
+            for (unsigned int k = 2; k < clause->size; ++k)
+            {
+                if (cdcl_value(solver, literals[k]) != -1)
+                {
+                    literals[1] = literals[k];
+                    literals[k] = false_literal;
+                    cdcl_watch_push(&solver->watches[cdcl_negate(literals[1])], clause, first);
+                    moved = true;
+                    break;
+                }
+            }
+
+            if (moved) { continue; }
+
+            // Every other literal is false: the clause is unit or conflicting.
+            list->items[j++] = watch;
+            if (cdcl_value(solver, first) == -1)
+            {
+                conflict = clause;
+                solver->propagated = solver->trail_size;
+                while (i < list->size) { list->items[j++] = list->items[i++]; }
+            }
+            else
+            {
+                cdcl_assign(solver, first, clause);
+            }
+        }
+
+        list->size = j;
+    }
+
+    return conflict;
+}
+
+/*
+ * Increases the activity of a variable, rescaling every activity when they grow too large.
+ */
+static void cdcl_bump_variable(cdcl_solver* solver, int variable)
+{
+    if ((solver->activity[variable] += solver->variable_increment) > 1e100)
+    {
+        for (int i = 0; i < solver->variables; ++i) { solver->activity[i] *= 1e-100; }
+        solver->variable_increment *= 1e-100;
+    }
+
+    if (solver->heap_index[variable] >= 0) { heap_up(solver, solver->heap_index[variable]); }
+}
+
+/*
+ * Increases the activity of a learnt clause, rescaling every clause activity when they grow too large.
+ */
+static void cdcl_bump_clause(cdcl_solver* solver, cdcl_clause* clause)
+{
+    if ((clause->activity += (float)solver->clause_increment) > 1e20f)
+    {
+        for (size_t i = 0; i < solver->learnt_count; ++i) { solver->learnts[i]->activity *= 1e-20f; }
+        solver->clause_increment *= 1e-20;
+    }
+}
+
+/*
+ * Checks if a literal of the learnt clause is implied by the other literals of the clause: every other literal of its
+ * reason is already in the clause or assigned at level 0, so the literal can be removed.
+ */
+static bool cdcl_redundant(cdcl_solver* solver, cdcl_literal literal)
+{
+    cdcl_clause* reason = solver->reasons[cdcl_var(literal)];
+    if (reason == NULL) { return false; }
+
+    for (unsigned int k = 1; k < reason->size; ++k)
+    {
+        int variable = cdcl_var(reason->literals[k]);
+        if (!solver->seen[variable] && solver->levels[variable] > 0) { return false; }
+    }
+
+    return true;
+}
+
+/*
+ * Analyzes a conflict and builds the first-UIP learnt clause in the buffer, with the asserting literal first and a
+ * literal of the backjump level second. Returns the size of the clause and sets the backjump level.
+ */
+static size_t cdcl_analyze(cdcl_solver* solver, cdcl_clause* conflict, int* backjump_level)
+{
+    size_t size = 1; // the asserting literal is stored first once it is known.
+    int paths = 0;
+    int index = solver->trail_size - 1;
+    cdcl_literal literal = 0;
+    bool first = true;
+
+    do
+    {
+        if (conflict->learnt) { cdcl_bump_clause(solver, conflict); }
+
+        // The first literal of a reason clause is the literal it implied, which is already resolved.
+        for (unsigned int k = first ? 0 : 1; k < conflict->size; ++k)
+        {
+            cdcl_literal other = conflict->literals[k];
+            int variable = cdcl_var(other);
+            if (solver->seen[variable] || solver->levels[variable] == 0) { continue; }
+
+            cdcl_bump_variable(solver, variable);
+            solver->seen[variable] = true;
+            if (solver->levels[variable] >= solver->decision_level)
+            {
+                ++paths;
+            }
+            else
+            {
+                solver->buffer = (cdcl_literal*)cdcl_reserve(solver->buffer, &solver->buffer_capacity, size + 1,
+                                                             sizeof(cdcl_literal));
+                solver->buffer[size++] = other;
+            }
+        }
+
+        // Resolve with the reason of the most recent marked literal of the conflict level.
+        while (!solver->seen[cdcl_var(solver->trail[index])]) { --index; }
+        literal = solver->trail[index--];
+        conflict = solver->reasons[cdcl_var(literal)];
+        solver->seen[cdcl_var(literal)] = false;
+        first = false;
+        --paths;
+    } while (paths > 0);
+
+    solver->buffer = (cdcl_literal*)cdcl_reserve(solver->buffer, &solver->buffer_capacity, size, sizeof(cdcl_literal));
+    solver->buffer[0] = cdcl_negate(literal);
+
+    // Move the literals implied by the rest of the clause to the end (swapping keeps every marked literal in the
+    // buffer), then clear the marks and drop the implied literals.
+    size_t kept = 1;
+    for (size_t i = 1; i < size; ++i)
+    {
+        if (!cdcl_redundant(solver, solver->buffer[i]))
+        {
+            cdcl_literal swap = solver->buffer[kept];
+            solver->buffer[kept++] = solver->buffer[i];
+            solver->buffer[i] = swap;
+        }
+    }
+
+    for (size_t i = 1; i < size; ++i) { solver->seen[cdcl_var(solver->buffer[i])] = false; }
+    size = kept;
+
+    // Move a literal of the highest remaining level to the second position (it becomes a watched literal).
+    *backjump_level = 0;
+    if (size > 1)
+    {
+        size_t highest = 1;
+        for (size_t i = 2; i < size; ++i)
+        {
+            if (solver->levels[cdcl_var(solver->buffer[i])] > solver->levels[cdcl_var(solver->buffer[highest])])
+            {
+                highest = i;
+            }
+        }
+
+        cdcl_literal swap = solver->buffer[1];
+        solver->buffer[1] = solver->buffer[highest];
+        solver->buffer[highest] = swap;
+        *backjump_level = solver->levels[cdcl_var(solver->buffer[1])];
+    }
+
+    return size;
+}
+
+/*
+ * Computes the literal block distance of the learnt clause in the buffer (the number of distinct decision levels).
+ */
+static unsigned int cdcl_lbd(cdcl_solver* solver, size_t size)
+{
+    unsigned int lbd = 0;
+    ++solver->stamp;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        int level = solver->levels[cdcl_var(solver->buffer[i])];
+        if (solver->level_stamps[level] != solver->stamp)
+        {
+            solver->level_stamps[level] = solver->stamp;
+            ++lbd;
+        }
+    }
+
+    return lbd;
+}
+
+/*
+ * Undoes the assignments above a decision level, saving the sign of each unassigned variable as its phase.
+ */
+static void cdcl_backtrack(cdcl_solver* solver, int level)
+{
+    if (solver->decision_level <= level) { return; }
+
+    for (int i = solver->trail_size - 1; i >= solver->trail_limits[level]; --i)
+    {
+        cdcl_literal literal = solver->trail[i];
+        int variable = cdcl_var(literal);
+        solver->values[literal] = 0;
+        solver->values[cdcl_negate(literal)] = 0;
+        solver->reasons[variable] = NULL;
+        solver->phases[variable] = (literal & 1u) != 0;
+        heap_insert(solver, variable);
+    }
+
+    solver->trail_size = solver->trail_limits[level];
+    solver->propagated = solver->trail_size;
+    solver->decision_level = level;
+}
+
+/*
+ * Checks if a learnt clause is the reason of a current assignment (such clauses cannot be removed).
+ */
+static bool cdcl_locked(cdcl_solver* solver, cdcl_clause* clause)
+{
+    cdcl_literal first = clause->literals[0];
+    return cdcl_value(solver, first) == 1 && solver->reasons[cdcl_var(first)] == clause;
+}
+
+/*
+ * Orders learnt clauses from the least to the most useful: clauses with a larger lbd first, then less active clauses.
+ */
+static int cdcl_compare_learnts(const void* a, const void* b)
+{
+    const cdcl_clause* clause1 = *(const cdcl_clause* const*)a;
+    const cdcl_clause* clause2 = *(const cdcl_clause* const*)b;
+
+    if (clause1->lbd != clause2->lbd) { return clause1->lbd > clause2->lbd ? -1 : 1; }
+    if (clause1->activity != clause2->activity) { return clause1->activity < clause2->activity ? -1 : 1; }
+    return 0;
+}
+
+/*
+ * Removes the less useful half of the learnt clauses, keeping the clauses with a small lbd and the reasons of current
+ * assignments, then drops the watches of the removed clauses.
+ */
+static void cdcl_reduce(cdcl_solver* solver)
+{
+    qsort(solver->learnts, solver->learnt_count, sizeof(cdcl_clause*), cdcl_compare_learnts);
+
+    size_t limit = solver->learnt_count / 2;
+    for (size_t i = 0; i < limit; ++i)
+    {
+        cdcl_clause* clause = solver->learnts[i];
+        if (clause->lbd > glue_lbd && clause->size > 2 && !cdcl_locked(solver, clause)) { clause->removed = true; }
+    }
+
+    for (int literal = 0; literal < 2 * solver->variables; ++literal)
+    {
+        cdcl_watch_list* list = &solver->watches[literal];
+        size_t j = 0;
+        for (size_t i = 0; i < list->size; ++i)
+        {
+            if (!list->items[i].clause->removed) { list->items[j++] = list->items[i]; }
+        }
+
+        list->size = j;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < solver->learnt_count; ++i)
+    {
+        cdcl_clause* clause = solver->learnts[i];
+        if (clause->removed)
+        {
+            solver->stats.live_bytes -= sizeof(cdcl_clause) + clause->size * sizeof(cdcl_literal);
+            free(clause);
+        }
+        else
+        {
+            solver->learnts[kept++] = clause;
+        }
+    }
+
+    solver->learnt_count = kept;
+    solver->max_learnts *= learnts_growth;
+    ++solver->stats.reductions;
+}
+
+/*
+ * Gets the element of the Luby sequence (1, 1, 2, 1, 1, 2, 4, 1, ...) at an index.
+ */
+static long cdcl_luby(long index)
+{
+    long size = 1;
+    int sequence = 0;
+
+    while (size < index + 1)
+    {
+        ++sequence;
+        size = 2 * size + 1;
+    }
+
+    while (size - 1 != index)
+    {
+        size = (size - 1) / 2;
+        --sequence;
+        index %= size;
+    }
+
+    return 1L << sequence;
+}
+
+/*
+ * Adds a clause to the solver (before solving or between calls to cdcl_solve). Duplicate literals are merged,
+ * clauses with complementary literals are ignored and literals that are false without any decision are dropped.
+ * Returns false if the clauses have become unsatisfiable.
+ */
+bool cdcl_add_clause(cdcl_solver* solver, const cdcl_literal* literals, size_t size)
+{
+    if (solver->inconsistent) { return false; }
+    cdcl_backtrack(solver, 0);
+
+    solver->buffer = (cdcl_literal*)cdcl_reserve(solver->buffer, &solver->buffer_capacity, size, sizeof(cdcl_literal));
+    size_t count = 0;
+    bool satisfied = false;
+
+    for (size_t i = 0; i < size && !satisfied; ++i)
+    {
+        cdcl_literal literal = literals[i];
+        int variable = cdcl_var(literal);
+        signed char value = cdcl_value(solver, literal);
+
+        if (value == 1)
+        {
+            satisfied = true; // the clause is true without any decision.
+        }
+        else if (value == 0 && solver->seen[variable])
+        {
+            // The variable is already in the clause: the literal is either a duplicate or complementary.
+            size_t k = 0;
+            while (cdcl_var(solver->buffer[k]) != variable) { ++k; }
+            satisfied = solver->buffer[k] != literal;
+        }
+        else if (value == 0)
+        {
+            solver->seen[variable] = true;
+            solver->buffer[count++] = literal;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) { solver->seen[cdcl_var(solver->buffer[i])] = false; }
+
+    if (satisfied) { return true; }
+
+    if (count == 0)
+    {
+        solver->inconsistent = true;
+        return false;
+    }
+
+    if (count == 1)
+    {
+        cdcl_assign(solver, solver->buffer[0], NULL);
+        solver->inconsistent = cdcl_propagate(solver) != NULL;
+        return !solver->inconsistent;
+    }
+
+    cdcl_attach(solver, solver->buffer, count, false);
+    return true;
+}
+
+/*
+ * Walker is the state of a local search over the original clauses: a full assignment, the clauses that contain each
+ * literal, the number of true literals of each clause and the set of falsified clauses. The variables assigned at
+ * level 0 and the assumptions are frozen, and the clauses they satisfy are left out of the walk.
+ */
+typedef struct cdcl_walker
+{
+    bool* values;               // value of each variable in the assignment.
+    bool* frozen;               // variables the walk may not flip.
+    size_t* starts;             // the clauses of literal l are occurrences[starts[l]] up to occurrences[starts[l + 1]].
+    size_t* occurrences;
+    unsigned int* true_counts;  // true literals of each clause (UINT_MAX for a clause left out of the walk).
+    size_t* positions;          // position of each falsified clause in the falsified set.
+    size_t* falsified;
+    size_t falsified_count;
+    int* flips;                 // variables flipped since the best assignment so far.
+    size_t flip_count;
+    size_t flip_capacity;
+} cdcl_walker;
+
+/*
+ * Gets the next number of the random stream of the solver (splitmix64).
+ */
+static inline uint64_t cdcl_next_random(cdcl_solver* solver)
+{
+    uint64_t z = (solver->random += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Checks if a literal is true in the assignment of the walker.
+ */
+static inline bool cdcl_walk_true(const cdcl_walker* walker, cdcl_literal literal)
+{
+    return walker->values[cdcl_var(literal)] != ((literal & 1u) != 0);
+}
+
+/*
+ * Adds a clause to the falsified set of the walker, or removes it.
+ */
+static inline void cdcl_walk_falsify(cdcl_walker* walker, size_t clause, bool falsified)
+{
+    if (falsified)
+    {
+        walker->positions[clause] = walker->falsified_count;
+        walker->falsified[walker->falsified_count++] = clause;
+    }
+    else
+    {
+        size_t last = walker->falsified[--walker->falsified_count];
+        walker->falsified[walker->positions[clause]] = last;
+        walker->positions[last] = walker->positions[clause];
+    }
+}
+
+/*
+ * Builds a walker that starts from the saved phases, with the values of level 0 and of the assumptions frozen.
+ */
+static void cdcl_walk_init(cdcl_walker* walker, cdcl_solver* solver, const cdcl_literal* assumptions, size_t count)
+{
+    size_t variables = (size_t)solver->variables;
+    size_t clauses = solver->clause_count;
+
+    walker->values = (bool*)malloc(variables * sizeof(bool));
+    walker->frozen = (bool*)malloc(variables * sizeof(bool));
+    for (size_t v = 0; v < variables; ++v)
+    {
+        signed char value = solver->levels[v] == 0 ? cdcl_value(solver, cdcl_lit((int)v, false)) : 0;
+        walker->values[v] = value != 0 ? value == 1 : !solver->phases[v];
+        walker->frozen[v] = value != 0;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        int variable = cdcl_var(assumptions[i]);
+        if (walker->frozen[variable]) { continue; }
+
+        walker->values[variable] = (assumptions[i] & 1u) == 0;
+        walker->frozen[variable] = true;
+    }
+
+    // Count the occurrences of each literal in the clauses of the walk, then fill them in.
+    walker->starts = (size_t*)calloc(2 * variables + 1, sizeof(size_t));
+    walker->true_counts = (unsigned int*)calloc(clauses + 1, sizeof(unsigned int));
+    for (size_t c = 0; c < clauses; ++c)
+    {
+        const cdcl_clause* clause = solver->clauses[c];
+        for (unsigned int k = 0; k < clause->size; ++k)
+        {
+            cdcl_literal literal = clause->literals[k];
+            if (walker->frozen[cdcl_var(literal)] && cdcl_walk_true(walker, literal))
+            {
+                walker->true_counts[c] = UINT_MAX;
+            }
+        }
+
+        if (walker->true_counts[c] == UINT_MAX) { continue; }
+        for (unsigned int k = 0; k < clause->size; ++k) { ++walker->starts[clause->literals[k] + 1]; }
+    }
+
+    for (size_t l = 0; l < 2 * variables; ++l) { walker->starts[l + 1] += walker->starts[l]; }
+
+    size_t* cursors = (size_t*)malloc((2 * variables + 1) * sizeof(size_t));
+    memcpy(cursors, walker->starts, (2 * variables + 1) * sizeof(size_t));
+    walker->occurrences = (size_t*)malloc((walker->starts[2 * variables] + 1) * sizeof(size_t));
+    walker->positions = (size_t*)malloc((clauses + 1) * sizeof(size_t));
+    walker->falsified = (size_t*)malloc((clauses + 1) * sizeof(size_t));
+    walker->falsified_count = 0;
+
+    for (size_t c = 0; c < clauses; ++c)
+    {
+        if (walker->true_counts[c] == UINT_MAX) { continue; }
+
+        const cdcl_clause* clause = solver->clauses[c];
+        for (unsigned int k = 0; k < clause->size; ++k)
+        {
+            cdcl_literal literal = clause->literals[k];
+            walker->occurrences[cursors[literal]++] = c;
+            if (cdcl_walk_true(walker, literal)) { ++walker->true_counts[c]; }
+        }
+
+        if (walker->true_counts[c] == 0) { cdcl_walk_falsify(walker, c, true); }
+    }
+
+    free(cursors);
+    walker->flips = NULL;
+    walker->flip_count = 0;
+    walker->flip_capacity = 0;
+}
+
+/*
+ * Frees the arrays of a walker.
+ */
+static void cdcl_walk_destroy(cdcl_walker* walker)
+{
+    free(walker->values);
+    free(walker->frozen);
+    free(walker->starts);
+    free(walker->occurrences);
+    free(walker->true_counts);
+    free(walker->positions);
+    free(walker->falsified);
+    free(walker->flips);
+}
+
+/*
+ * Counts the clauses that making a false literal true would falsify: the clauses whose only true literal is its
+ * negation.
+ */
+static unsigned int cdcl_walk_breaks(const cdcl_walker* walker, cdcl_literal literal)
+{
+    cdcl_literal negation = cdcl_negate(literal);
+    unsigned int breaks = 0;
+    for (size_t i = walker->starts[negation]; i < walker->starts[negation + 1]; ++i)
+    {
+        if (walker->true_counts[walker->occurrences[i]] == 1) { ++breaks; }
+    }
+
+    return breaks;
+}
+
+/*
+ * Makes a false literal true by flipping its variable, updating the true counts and the falsified set.
+ */
+static void cdcl_walk_flip(cdcl_walker* walker, cdcl_literal literal)
+{
+    walker->values[cdcl_var(literal)] = (literal & 1u) == 0;
+
+    for (size_t i = walker->starts[literal]; i < walker->starts[literal + 1]; ++i)
+    {
+        size_t clause = walker->occurrences[i];
+        if (walker->true_counts[clause]++ == 0) { cdcl_walk_falsify(walker, clause, false); }
+    }
+
+    cdcl_literal negation = cdcl_negate(literal);
+    for (size_t i = walker->starts[negation]; i < walker->starts[negation + 1]; ++i)
+    {
+        size_t clause = walker->occurrences[i];
+        if (--walker->true_counts[clause] == 0) { cdcl_walk_falsify(walker, clause, true); }
+    }
+}
+
+/*
+ * Resets the saved phases from a local search (WalkSAT) over the original clauses that starts from the saved phases
+ * and flips up to walk_effort times the number of clauses. Each step picks a random falsified clause and flips the
+ * literal that falsifies the fewest other clauses, or a random literal of the clause with some noise unless a flip
+ * falsifies nothing. The phases take the best assignment of the walk, so the search continues from an assignment that
+ * falsifies few clauses (a satisfying one is then found without conflicts). Phase saving alone keeps only the values
+ * undone by the last backjump, which on large satisfiable instances are far from any model.
+ */
+static void cdcl_walk(cdcl_solver* solver, const cdcl_literal* assumptions, size_t count)
+{
+    cdcl_walker walker;
+    cdcl_walk_init(&walker, solver, assumptions, count);
+    size_t best = walker.falsified_count;
+    long flips = walk_effort * (long)solver->clause_count;
+
+    for (long step = 0; step < flips && walker.falsified_count > 0; ++step)
+    {
+        if (solver->budget != NULL &&
+            budget_exhausted(solver->budget, solver->stats.conflicts, solver->stats.live_bytes))
+        {
+            break;
+        }
+
+        size_t index = walker.falsified[cdcl_next_random(solver) % walker.falsified_count];
+        const cdcl_clause* clause = solver->clauses[index];
+        cdcl_literal chosen = 0;
+        unsigned int fewest = UINT_MAX;
+        unsigned int candidates = 0;
+        for (unsigned int k = 0; k < clause->size; ++k)
+        {
+            cdcl_literal literal = clause->literals[k];
+            if (walker.frozen[cdcl_var(literal)]) { continue; }
+
+            ++candidates;
+            unsigned int breaks = cdcl_walk_breaks(&walker, literal);
+            if (breaks < fewest)
+            {
+                fewest = breaks;
+                chosen = literal;
+            }
+        }
+
+        if (candidates == 0) { break; } // the clause is false under level 0 and the assumptions.
+
+        if (fewest > 0 && cdcl_next_random(solver) % 1000 < walk_noise)
+        {
+            unsigned int pick = (unsigned int)(cdcl_next_random(solver) % candidates);
+            for (unsigned int k = 0; k < clause->size; ++k)
+            {
+                if (walker.frozen[cdcl_var(clause->literals[k])]) { continue; }
+                if (pick-- == 0)
+                {
+                    chosen = clause->literals[k];
+                    break;
+                }
+            }
+        }
+
+        cdcl_walk_flip(&walker, chosen);
+        if (walker.falsified_count < best)
+        {
+            best = walker.falsified_count;
+            walker.flip_count = 0;
+        }
+        else
+        {
+            walker.flips = (int*)cdcl_reserve(walker.flips, &walker.flip_capacity, walker.flip_count + 1, sizeof(int));
+            walker.flips[walker.flip_count++] = cdcl_var(chosen);
+        }
+    }
+
+    // Undo the flips made since the best assignment, then save it as the phases.
+    for (size_t i = 0; i < walker.flip_count; ++i) { walker.values[walker.flips[i]] = !walker.values[walker.flips[i]]; }
+    for (int v = 0; v < solver->variables; ++v)
+    {
+        if (!walker.frozen[v]) { solver->phases[v] = !walker.values[v]; }
+    }
+
+    cdcl_walk_destroy(&walker);
+    ++solver->stats.walks;
+}
+
+/*
+ * Searches for a satisfying assignment of the clauses. Returns true and records the assignment as the model if the
+ * clauses are satisfiable, and false if they are unsatisfiable. Clauses can be added again after the call.
+ */
+bool cdcl_solve(cdcl_solver* solver)
+{
+    return cdcl_solve_assuming(solver, NULL, 0);
+}
+
+/*
+ * Finds the first assumption that is not true yet. Returns false if an assumption is false, otherwise sets the
+ * decision to the unassigned assumption (or leaves it unchanged if every assumption is true).
+ */
+static bool cdcl_next_assumption(cdcl_solver* solver, const cdcl_literal* assumptions, size_t count,
+                                 cdcl_literal* decision)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        signed char value = cdcl_value(solver, assumptions[i]);
+        if (value == -1) { return false; }
+        if (value == 0)
+        {
+            *decision = assumptions[i];
+            return true;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Searches for a satisfying assignment of the clauses in which every assumption is true. The assumptions are decided
+ * before any other variable, so the learnt clauses do not depend on them and stay valid for later calls. Returns false
+ * if the clauses are unsatisfiable together with the assumptions (the clauses alone may still be satisfiable), or if
+ * the budget of the solver runs out, in which case the stopped flag is set and the solver can be used again.
+ */
+bool cdcl_solve_assuming(cdcl_solver* solver, const cdcl_literal* assumptions, size_t count)
+{
+    solver->stopped = false;
+    if (solver->inconsistent) { return false; }
+
+    long restarts = 0;
+    long conflicts_left = restart_unit * cdcl_luby(restarts);
+
+    while (true)
+    {
+        if (solver->budget != NULL &&
+            budget_exhausted(solver->budget, solver->stats.conflicts, solver->stats.live_bytes))
+        {
+            cdcl_backtrack(solver, 0);
+            solver->stopped = true;
+            return false;
+        }
+
+        cdcl_clause* conflict = cdcl_propagate(solver);
+
+        if (conflict != NULL)
+        {
+            ++solver->stats.conflicts;
+            if (solver->decision_level == 0)
+            {
+                solver->inconsistent = true; // the conflict does not depend on any decision.
+                return false;
+            }
+
+            int level;
+            size_t size = cdcl_analyze(solver, conflict, &level);
+            unsigned int lbd = cdcl_lbd(solver, size);
+            cdcl_backtrack(solver, level);
+
+            if (size == 1)
+            {
+                cdcl_assign(solver, solver->buffer[0], NULL);
+            }
+            else
+            {
+                cdcl_clause* learnt = cdcl_attach(solver, solver->buffer, size, true);
+                learnt->lbd = lbd;
+                cdcl_bump_clause(solver, learnt);
+                cdcl_assign(solver, solver->buffer[0], learnt);
+            }
+
+            solver->variable_increment /= variable_decay;
+            solver->clause_increment /= clause_decay;
+
+            if (--conflicts_left == 0)
+            {
+                // Restart: keep the learnt clauses, activities and phases but undo every decision. Restarts 1, 2, 4,
+                // 8, ... also reset the phases from a local search, so its cost stays small next to the search.
+                cdcl_backtrack(solver, 0);
+                ++solver->stats.restarts;
+                ++restarts;
+                if ((restarts & (restarts - 1)) == 0) { cdcl_walk(solver, assumptions, count); }
+                conflicts_left = restart_unit * cdcl_luby(restarts);
+            }
+
+            continue;
+        }
+
+        if ((double)solver->learnt_count >= solver->max_learnts + solver->trail_size)
+        {
+            cdcl_reduce(solver);
+        }
+
+        // Decide the first unassigned assumption, or else the unassigned variable with the largest activity using
+        // its saved phase.
+        cdcl_literal decision = (cdcl_literal)-1;
+        if (!cdcl_next_assumption(solver, assumptions, count, &decision))
+        {
+            cdcl_backtrack(solver, 0);
+            return false; // an assumption is false under the clauses and the other assumptions.
+        }
+
+        int variable = decision != (cdcl_literal)-1 ? cdcl_var(decision) : -1;
+        while (solver->heap_size > 0 && variable < 0)
+        {
+            int candidate = heap_pop(solver);
+            if (cdcl_value(solver, cdcl_lit(candidate, false)) == 0)
+            {
+                variable = candidate;
+                decision = cdcl_lit(variable, solver->phases[variable]);
+            }
+        }
+
+        if (variable < 0)
+        {
+            // Every variable is assigned without a conflict, so the assignment satisfies every clause.
+            for (int i = 0; i < solver->variables; ++i)
+            {
+                solver->model[i] = cdcl_value(solver, cdcl_lit(i, false)) == 1;
+            }
+
+            cdcl_backtrack(solver, 0);
+            return true;
+        }
+
+        ++solver->stats.decisions;
+        solver->trail_limits[solver->decision_level++] = solver->trail_size;
+        cdcl_assign(solver, decision, NULL);
+    }
+}
+
+/*
+ * Gets the value of a variable in the model found by the last successful call to cdcl_solve.
+ */
+bool cdcl_model_value(cdcl_solver* solver, int variable)
+{
+    return solver->model[variable];
+}
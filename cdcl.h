@@ -0,0 +1,141 @@
+#ifndef THEOREMPROVER_CDCL_H
+#define THEOREMPROVER_CDCL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "budget.h"
+
+/*
+ * A CDCL literal is a variable with a sign: 2 * variable for the positive literal and 2 * variable + 1 for the
+ * negative literal, so the negation of a literal flips the lowest bit.
+ */
+typedef unsigned int cdcl_literal;
+
+/*
+ * CDCL clause stores its literals inline. The first two literals are the watched literals, and the first literal of
+ * a clause that is the reason of an assignment is the assigned literal.
+ */
+typedef struct cdcl_clause
+{
+    unsigned int size;
+    unsigned int lbd;   // number of distinct decision levels when the clause was learnt (0 for original clauses).
+    bool learnt;
+    bool removed;       // set while a clause database reduction detaches the clause.
+    float activity;     // bumped when the learnt clause takes part in a conflict.
+    cdcl_literal literals[];
+} cdcl_clause;
+
+/*
+ * Watch refers to a clause from the watch list of one of its watched literals. The blocker is another literal of the
+ * clause: if it is true the clause is satisfied and the clause itself does not need to be visited.
+ */
+typedef struct cdcl_watch
+{
+    cdcl_clause* clause;
+    cdcl_literal blocker;
+} cdcl_watch;
+
+typedef struct cdcl_watch_list
+{
+    cdcl_watch* items;
+    size_t size;
+    size_t capacity;
+} cdcl_watch_list;
+
+/*
+ * CDCL statistics describe the search of one solver.
+ */
+typedef struct cdcl_stats
+{
+    long decisions;
+    long conflicts;
+    long propagations;
+    long restarts;
+    long reductions;   // number of clause database reductions.
+    long walks;        // number of local search walks that reset the phases.
+    size_t live_bytes; // bytes currently allocated for clauses.
+    size_t peak_bytes; // peak bytes allocated for clauses.
+    size_t total_bytes;
+} cdcl_stats;
+
+/*
+ * CDCL solver decides the satisfiability of a set of clauses with conflict-driven clause learning: unit propagation
+ * with two watched literals, first-UIP conflict analysis, VSIDS decisions with phase saving, Luby restarts, phases
+ * reset by a local search walk at some restarts and periodic reduction of the learnt clause database.
+ */
+typedef struct cdcl_solver
+{
+    int variables;
+    int capacity;               // number of variables the per-variable arrays can hold.
+
+    signed char* values;        // value of each literal: 1 true, -1 false, 0 unassigned.
+    int* levels;                // decision level of each assigned variable.
+    cdcl_clause** reasons;      // clause that implied each assigned variable (NULL for decisions).
+    bool* phases;               // saved sign of each variable (true if its last value was false).
+    bool* model;                // value of each variable in the last satisfying assignment.
+    bool* seen;                 // marks used by conflict analysis.
+    double* activity;           // VSIDS activity of each variable.
+    int* heap;                  // binary max heap of unassigned variables ordered by activity.
+    int* heap_index;            // position of each variable in the heap (-1 if it is not in the heap).
+    int heap_size;
+    cdcl_watch_list* watches;   // clauses watching each literal (visited when the literal becomes false).
+
+    cdcl_literal* trail;        // assigned literals in assignment order.
+    int trail_size;
+    int* trail_limits;          // trail size at the start of each decision level.
+    int decision_level;
+    int propagated;             // number of trail literals whose watches have been visited.
+
+    cdcl_clause** clauses;      // original clauses.
+    size_t clause_count;
+    size_t clause_capacity;
+    cdcl_clause** learnts;      // learnt clauses.
+    size_t learnt_count;
+    size_t learnt_capacity;
+    double max_learnts;         // learnt clauses allowed before the database is reduced.
+
+    cdcl_literal* buffer;       // learnt clause under construction.
+    size_t buffer_capacity;
+    int* level_stamps;          // per decision level stamps used to compute the lbd of learnt clauses.
+    int stamp;
+
+    double variable_increment;
+    double clause_increment;
+    bool inconsistent;          // the clauses are unsatisfiable without any decision.
+    budget* budget;             // limits of the search (NULL for none), checked before every conflict and decision.
+    bool stopped;               // the last solve ran out of budget, so its false result is unknown.
+    uint64_t random;            // state of the random stream of the local search.
+    cdcl_stats stats;
+} cdcl_solver;
+
+static inline cdcl_literal cdcl_lit(int variable, bool negated)
+{
+    return 2u * (unsigned int)variable + (negated ? 1u : 0u);
+}
+
+static inline int cdcl_var(cdcl_literal literal)
+{
+    return (int)(literal >> 1);
+}
+
+static inline cdcl_literal cdcl_negate(cdcl_literal literal)
+{
+    return literal ^ 1u;
+}
+
+cdcl_solver* cdcl_create();
+
+void cdcl_free(cdcl_solver* solver);
+
+int cdcl_new_var(cdcl_solver* solver);
+
+bool cdcl_add_clause(cdcl_solver* solver, const cdcl_literal* literals, size_t size);
+
+bool cdcl_solve(cdcl_solver* solver);
+
+bool cdcl_solve_assuming(cdcl_solver* solver, const cdcl_literal* assumptions, size_t count);
+
+bool cdcl_model_value(cdcl_solver* solver, int variable);
+
+#endif //THEOREMPROVER_CDCL_H
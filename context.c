@@ -0,0 +1,197 @@
+#include "context.h"
+#include "tree.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Creates an empty context with its own factory and solver.
+ */
+solver_context* context_create()
+{
+    solver_context* context = (solver_context*)calloc(1, sizeof(solver_context));
+    context->factory = factory_create();
+    context->solver = cdcl_create();
+    tseitin_init(&context->encoder, context->factory, context->solver);
+    return context;
+}
+
+/*
+ * Frees the context with its solver and formulas.
+ */
+void context_free(solver_context* context)
+{
+    if (context == NULL) { return; }
+
+    tseitin_destroy(&context->encoder);
+    cdcl_free(context->solver);
+    factory_free(context->factory);
+    free(context->scopes);
+    free(context->assumptions);
+    free(context->selectors);
+    free(context);
+}
+
+/*
+ * Asserts a formula of the context factory in the innermost open scope (or permanently if no scope is open).
+ */
+void context_assert(solver_context* context, tree_node* formula)
+{
+    if (context->scope_count == 0)
+    {
+        tseitin_assert(&context->encoder, formula, false);
+    }
+    else
+    {
+        tseitin_assert_guarded(&context->encoder, formula, context->scopes[context->scope_count - 1]);
+    }
+}
+
+/*
+ * Opens a new assertion scope with a fresh selector variable.
+ */
+void context_push(solver_context* context)
+{
+    if (context->scope_count == context->scope_capacity)
+    {
+        context->scope_capacity = context->scope_capacity > 0 ? 2 * context->scope_capacity : 16;
+        context->scopes = (cdcl_literal*)realloc(context->scopes, context->scope_capacity * sizeof(cdcl_literal));
+    }
+
+    context->scopes[context->scope_count++] = cdcl_lit(cdcl_new_var(context->solver), true);
+}
+
+/*
+ * Closes the innermost scope, removing the formulas asserted in it. Returns false if no scope is open.
+ */
+bool context_pop(solver_context* context)
+{
+    if (context->scope_count == 0) { return false; }
+
+    cdcl_literal guard = context->scopes[--context->scope_count];
+    cdcl_add_clause(context->solver, &guard, 1);
+    return true;
+}
+
+/*
+ * Gets the number of open scopes.
+ */
+size_t context_scopes(solver_context* context)
+{
+    return context->scope_count;
+}
+
+/*
+ * Gets the literal to assume for a formula: the solver literal of a literal formula, or the selector of a
+ * non-literal formula, which is asserted under its selector the first time it is assumed.
+ */
+static cdcl_literal context_assumption(solver_context* context, tree_node* formula)
+{
+    if (formula->token.type == proposition)
+    {
+        return cdcl_lit(tseitin_proposition_var(&context->encoder, formula->token.id), false);
+    }
+
+    if (formula->token.type == negation && formula->left_child->token.type == proposition)
+    {
+        return cdcl_lit(tseitin_proposition_var(&context->encoder, formula->left_child->token.id), true);
+    }
+
+    if (formula->index >= context->selector_capacity)
+    {
+        size_t capacity = context->selector_capacity > 0 ? context->selector_capacity : 64;
+        while (capacity <= formula->index) { capacity *= 2; }
+
+        context->selectors = (int*)realloc(context->selectors, capacity * sizeof(int));
+        memset(context->selectors + context->selector_capacity, 0xff,
+               (capacity - context->selector_capacity) * sizeof(int));
+        context->selector_capacity = capacity;
+    }
+
+    if (context->selectors[formula->index] < 0)
+    {
+        int selector = cdcl_new_var(context->solver);
+        tseitin_assert_guarded(&context->encoder, formula, cdcl_lit(selector, true));
+        context->selectors[formula->index] = selector;
+    }
+
+    return cdcl_lit(context->selectors[formula->index], false);
+}
+
+/*
+ * Checks whether the asserted formulas of the open scopes are satisfiable together with the assumptions (formulas of
+ * the context factory that only hold for this check). The statistics (which may be NULL) describe this check alone,
+ * apart from the bytes, which cover every clause of the context.
+ */
+bool context_check(solver_context* context, tree_node** assumptions, size_t count, prover_stats* stats)
+{
+    size_t needed = context->scope_count + count;
+    if (needed > context->assumption_capacity)
+    {
+        context->assumption_capacity = 2 * needed;
+        context->assumptions = (cdcl_literal*)realloc(context->assumptions,
+                                                      context->assumption_capacity * sizeof(cdcl_literal));
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < context->scope_count; ++i)
+    {
+        context->assumptions[size++] = cdcl_negate(context->scopes[i]); // the selector of every open scope.
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        context->assumptions[size++] = context_assumption(context, assumptions[i]);
+    }
+
+    long decisions = context->solver->stats.decisions;
+    long conflicts = context->solver->stats.conflicts;
+    context->satisfiable = cdcl_solve_assuming(context->solver, context->assumptions, size);
+
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+        stats->decisions = context->solver->stats.decisions - decisions;
+        stats->conflicts = context->solver->stats.conflicts - conflicts;
+        stats->peak_bytes = context->solver->stats.peak_bytes;
+        stats->total_bytes = context->solver->stats.total_bytes;
+    }
+
+    return context->satisfiable;
+}
+
+/*
+ * Gets the value of a proposition in the model of the last check (false if the proposition does not occur in the
+ * asserted formulas, or if the last check was not satisfiable).
+ */
+bool context_value(solver_context* context, int id)
+{
+    if (!context->satisfiable || (size_t)id >= context->encoder.proposition_capacity) { return false; }
+
+    int variable = context->encoder.proposition_vars[id];
+    return variable >= 0 && cdcl_model_value(context->solver, variable);
+}
+
+/*
+ * Fills the model with the values of the propositions of the context factory in the model of the last check.
+ * Returns false (leaving the model empty) if the last check was not satisfiable.
+ */
+bool context_model(solver_context* context, prover_model* model)
+{
+    if (!context->satisfiable)
+    {
+        model->size = 0;
+        model->propositions = NULL;
+        model->values = NULL;
+        return false;
+    }
+
+    size_t count = (size_t)symbol_count() + 1;
+    bool* valuation = (bool*)calloc(count, sizeof(bool));
+    for (size_t id = 0; id < count; ++id) { valuation[id] = context_value(context, (int)id); }
+
+    prover_model_create(model, context->factory, valuation);
+    free(valuation);
+    return true;
+}
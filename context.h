@@ -0,0 +1,52 @@
+#ifndef THEOREMPROVER_CONTEXT_H
+#define THEOREMPROVER_CONTEXT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "factory.h"
+#include "cdcl.h"
+#include "tseitin.h"
+#include "prover.h"
+
+/*
+ * Solver context answers a sequence of related satisfiability queries incrementally. Formulas are asserted into one
+ * CDCL solver through a Tseitin encoder that lives as long as the context, so the clauses and gates of the base theory
+ * are encoded once and the clauses learnt by one check are kept for the next.
+ * Assertion scopes are implemented with selector variables: a formula asserted inside a scope is guarded by the
+ * selector of the innermost scope, every check assumes the selectors of the open scopes, and popping a scope asserts
+ * the negation of its selector, which disables its formulas for good.
+ */
+typedef struct solver_context
+{
+    formula_factory* factory;   // owns the formulas of the context.
+    cdcl_solver* solver;
+    tseitin_encoder encoder;
+    cdcl_literal* scopes;       // guard (negated selector) of each open scope, innermost last.
+    size_t scope_count;
+    size_t scope_capacity;
+    cdcl_literal* assumptions;  // literals assumed by the current check.
+    size_t assumption_capacity;
+    int* selectors;             // selector variable of each assumed non-literal formula by node index (-1 if none).
+    size_t selector_capacity;
+    bool satisfiable;           // result of the last check (the model is only available if it was satisfiable).
+} solver_context;
+
+solver_context* context_create();
+
+void context_free(solver_context* context);
+
+void context_assert(solver_context* context, tree_node* formula);
+
+void context_push(solver_context* context);
+
+bool context_pop(solver_context* context);
+
+size_t context_scopes(solver_context* context);
+
+bool context_check(solver_context* context, tree_node** assumptions, size_t count, prover_stats* stats);
+
+bool context_value(solver_context* context, int id);
+
+bool context_model(solver_context* context, prover_model* model);
+
+#endif //THEOREMPROVER_CONTEXT_H
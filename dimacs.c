@@ -0,0 +1,299 @@
+#include "dimacs.h"
+#include "theory.h"
+#include "tree.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DIMACS_MAX_VARIABLES (1 << 26) // largest variable accepted (larger ones are a parse error).
+
+/*
+ * DIMACS reader streams the input through a fixed size buffer, so memory used while reading is bounded by the buffer,
+ * the literals of the current clause and the variable to symbol id map, independent of the size of the file. The map
+ * grows with the largest variable that actually appears in a clause, not with the count of the problem line.
+ */
+typedef struct dimacs_reader
+{
+    formula_factory* factory;
+    FILE* input;
+    char buffer[1 << 16];
+    size_t position;
+    size_t length;
+    tree_node** literals; // literals[2v] and literals[2v + 1] are the formulas v and -v (or NULL if not yet created).
+    size_t variables;     // capacity of the literals array (in variables).
+    tree_node** clause; // literals of the clause currently being read.
+    int clause_size;
+    int clause_capacity;
+} dimacs_reader;
+
+/*
+ * Gets the next character of the input, refilling the buffer when it runs out (EOF at the end of the input).
+ */
+static inline int dimacs_next(dimacs_reader* reader)
+{
+    if (reader->position == reader->length)
+    {
+        reader->length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->input);
+        reader->position = 0;
+        if (reader->length == 0) { return EOF; }
+    }
+
+    return (unsigned char)reader->buffer[reader->position++];
+}
+
+/*
+ * Skips the rest of the current line.
+ */
+static void dimacs_skip_line(dimacs_reader* reader)
+{
+    int c;
+    do { c = dimacs_next(reader); } while (c != '\n' && c != EOF);
+}
+
+/*
+ * Checks if the character is a whitespace (including new lines).
+ */
+static inline bool dimacs_is_space(int c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/*
+ * Reads a (possibly negative) decimal integer whose first character has already been read.
+ * Returns false if the characters do not form an integer.
+ */
+static bool dimacs_read_int(dimacs_reader* reader, int c, long* value)
+{
+    bool negative = false;
+    if (c == '-')
+    {
+        negative = true;
+        c = dimacs_next(reader);
+    }
+
+    if (c < '0' || c > '9') { return false; }
+
+    long n = 0;
+    while (c >= '0' && c <= '9')
+    {
+        n = 10 * n + (c - '0');
+        if (n > 0x7fffffffL) { return false; }
+        c = dimacs_next(reader);
+    }
+
+    if (c != EOF && !dimacs_is_space(c)) { return false; }
+
+    *value = negative ? -n : n;
+    return true;
+}
+
+/*
+ * Grows the literal cache so that it can hold the variable (at most DIMACS_MAX_VARIABLES, so the doubling cannot
+ * overflow).
+ */
+static void dimacs_reserve(dimacs_reader* reader, size_t variable)
+{
+    if (variable >= reader->variables)
+    {
+        size_t capacity = reader->variables == 0 ? 1024 : reader->variables;
+        while (capacity <= variable) { capacity *= 2; }
+        if (capacity > (size_t)DIMACS_MAX_VARIABLES + 1) { capacity = (size_t)DIMACS_MAX_VARIABLES + 1; }
+
+        reader->literals = (tree_node**)realloc(reader->literals, 2 * capacity * sizeof(tree_node*));
+        memset(reader->literals + 2 * reader->variables, 0, 2 * (capacity - reader->variables) * sizeof(tree_node*));
+        reader->variables = capacity;
+    }
+}
+
+/*
+ * Gets the formula for a DIMACS literal (v for a positive literal and -v for a negative literal), naming variable v
+ * as "x<v>". Both literals of a variable are created together the first time the variable is seen.
+ */
+static tree_node* dimacs_literal(dimacs_reader* reader, long literal)
+{
+    long variable = literal < 0 ? -literal : literal;
+    dimacs_reserve(reader, (size_t)variable);
+
+    tree_node** literals = reader->literals + 2 * (size_t)variable;
+    if (literals[0] == NULL)
+    {
+        char name[16];
+        int length = snprintf(name, sizeof(name), "x%ld", variable);
+
+        token prop;
+        token_init_proposition(&prop, symbol_intern(name, (size_t)length));
+        token negated;
+        token_init(&negated, negation, '-');
+
+        literals[0] = proposition_formula(reader->factory, prop);
+        literals[1] = negated_formula(reader->factory, negated, literals[0]);
+    }
+
+    return literals[literal < 0 ? 1 : 0];
+}
+
+/*
+ * Combines the literals of the current clause into a balanced disjunction (depth logarithmic in the clause size).
+ * The empty clause is represented by the contradiction (_false ^ -_false).
+ */
+static tree_node* dimacs_clause(dimacs_reader* reader)
+{
+    if (reader->clause_size == 0)
+    {
+        token prop;
+        token_init_proposition(&prop, symbol_intern("_false", 6));
+        token negated;
+        token_init(&negated, negation, '-');
+        token conjunction;
+        token_init(&conjunction, binary_connective, '^');
+        tree_node* node = proposition_formula(reader->factory, prop);
+        return binary_formula(reader->factory, conjunction, node, negated_formula(reader->factory, negated, node));
+    }
+
+    token disjunction;
+    token_init(&disjunction, binary_connective, 'v');
+
+    int n = reader->clause_size;
+    while (n > 1)
+    {
+        int m = 0;
+        for (int i = 0; i + 1 < n; i += 2)
+        {
+            reader->clause[m++] = binary_formula(reader->factory, disjunction, reader->clause[i], reader->clause[i + 1]);
+        }
+        if (n % 2 == 1)
+        {
+            reader->clause[m++] = reader->clause[n - 1];
+        }
+        n = m;
+    }
+
+    reader->clause_size = 0;
+    return reader->clause[0];
+}
+
+/*
+ * Frees the reader buffers (the formulas are owned by the factory).
+ */
+static void dimacs_reader_free(dimacs_reader* reader)
+{
+    free(reader->clause);
+    free(reader->literals);
+    free(reader);
+}
+
+/*
+ * Reads a CNF formula in DIMACS format and streams each clause into a theory (one disjunction per clause), storing the
+ * number of clauses read in clauses if it is not NULL (the theory may hold fewer formulas, since equal clauses share a
+ * formula). The clause formulas are created in the factory. Returns NULL and reports the error on stderr if the input
+ * is malformed.
+ */
+theory* dimacs_read(formula_factory* factory, FILE* input, long* clauses)
+{
+    dimacs_reader* reader = (dimacs_reader*)calloc(1, sizeof(dimacs_reader));
+    reader->factory = factory;
+    reader->input = input;
+
+    theory* set = theory_create(factory->arena);
+    long count = 0;
+    bool header = false;
+    int c;
+
+    while ((c = dimacs_next(reader)) != EOF)
+    {
+        if (dimacs_is_space(c)) { continue; }
+
+        if (c == 'c')
+        {
+            dimacs_skip_line(reader); // comment line.
+            continue;
+        }
+
+        if (c == '%') { break; } // end of formula marker used by some benchmark sets.
+
+        if (c == 'p' && !header)
+        {
+            // problem line: p cnf <variables> <clauses>. The counts are only checked, since the clauses that follow
+            // decide how many variables are used.
+            char line[128];
+            size_t length = 0;
+            while ((c = dimacs_next(reader)) != '\n' && c != EOF)
+            {
+                if (length < sizeof(line) - 1) { line[length++] = (char)c; }
+            }
+            line[length] = '\0';
+
+            long variables;
+            long declared;
+            if (sscanf(line, " cnf %ld %ld", &variables, &declared) != 2 || variables < 0 || declared < 0 ||
+                variables > DIMACS_MAX_VARIABLES)
+            {
+                fprintf(stderr, "dimacs: malformed problem line\n");
+                dimacs_reader_free(reader);
+                theory_free(set);
+                return NULL;
+            }
+
+            header = true;
+            continue;
+        }
+
+        long literal;
+        if (!dimacs_read_int(reader, c, &literal) || literal > DIMACS_MAX_VARIABLES || literal < -DIMACS_MAX_VARIABLES)
+        {
+            fprintf(stderr, "dimacs: unexpected input\n");
+            dimacs_reader_free(reader);
+            theory_free(set);
+            return NULL;
+        }
+
+        if (literal == 0)
+        {
+            theory_push(set, dimacs_clause(reader)); // end of clause.
+            ++count;
+            continue;
+        }
+
+        if (reader->clause_size == reader->clause_capacity)
+        {
+            reader->clause_capacity = reader->clause_capacity == 0 ? 16 : 2 * reader->clause_capacity;
+            reader->clause = (tree_node**)realloc(reader->clause, reader->clause_capacity * sizeof(tree_node*));
+        }
+
+        reader->clause[reader->clause_size++] = dimacs_literal(reader, literal);
+    }
+
+    if (reader->clause_size > 0)
+    {
+        theory_push(set, dimacs_clause(reader)); // the last clause may omit its terminating zero.
+        ++count;
+    }
+
+    if (clauses != NULL) { *clauses = count; }
+    dimacs_reader_free(reader);
+    return set;
+}
+
+/*
+ * Reads a DIMACS CNF file (or standard input when the path is NULL or "-") into a theory, storing the number of
+ * clauses read in clauses if it is not NULL.
+ */
+theory* dimacs_load(formula_factory* factory, const char* path, long* clauses)
+{
+    if (path == NULL || strcmp(path, "-") == 0)
+    {
+        return dimacs_read(factory, stdin, clauses);
+    }
+
+    FILE* input = fopen(path, "r");
+    if (input == NULL)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return NULL;
+    }
+
+    theory* set = dimacs_read(factory, input, clauses);
+    fclose(input);
+    return set;
+}
@@ -0,0 +1,13 @@
+#ifndef THEOREMPROVER_DIMACS_H
+#define THEOREMPROVER_DIMACS_H
+
+#include <stdio.h>
+
+typedef struct theory theory;
+typedef struct formula_factory formula_factory;
+
+theory* dimacs_read(formula_factory* factory, FILE* input, long* clauses);
+
+theory* dimacs_load(formula_factory* factory, const char* path, long* clauses);
+
+#endif //THEOREMPROVER_DIMACS_H
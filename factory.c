@@ -0,0 +1,115 @@
+#include "factory.h"
+#include "tree.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static const size_t initial_slots = 256;
+
+/*
+ * Creates an empty formula factory.
+ */
+formula_factory* factory_create()
+{
+    formula_factory* factory = (formula_factory*)malloc(sizeof(formula_factory));
+    factory->slots = (factory_slot*)calloc(initial_slots, sizeof(factory_slot));
+    factory->mask = initial_slots - 1;
+    factory->size = 0;
+    factory->propositions = 0;
+    factory->arena = arena_create();
+    return factory;
+}
+
+/*
+ * Frees the factory and every node it has created.
+ */
+void factory_free(formula_factory* factory)
+{
+    if (factory != NULL)
+    {
+        arena_free(factory->arena);
+        free(factory->slots);
+        free(factory);
+    }
+}
+
+/*
+ * Hashes a node from its token and the addresses of its children (children are already unique so their addresses
+ * identify them exactly, and hashing the addresses avoids loading the children from memory).
+ */
+static unsigned int factory_hash(token token, tree_node* left_child, tree_node* right_child)
+{
+    uint64_t h = (uint64_t)token.type;
+    h = h * 31 + (unsigned char)token.symbol;
+    h = h * 1000003 + (uint32_t)token.id;
+    h = h * 1000003 + (uintptr_t)left_child;
+    h = h * 1000003 + (uintptr_t)right_child;
+
+    // Final avalanche (from MurmurHash3) so consecutive indices spread over the slots.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (unsigned int)h;
+}
+
+/*
+ * Doubles the number of slots and reinserts every node.
+ */
+static void factory_grow(formula_factory* factory)
+{
+    size_t mask = 2 * (factory->mask + 1) - 1;
+    factory_slot* slots = (factory_slot*)calloc(mask + 1, sizeof(factory_slot));
+
+    for (size_t i = 0; i <= factory->mask; ++i)
+    {
+        if (factory->slots[i].node != NULL)
+        {
+            size_t slot = factory->slots[i].hash & mask;
+            while (slots[slot].node != NULL) { slot = (slot + 1) & mask; }
+            slots[slot] = factory->slots[i];
+        }
+    }
+
+    free(factory->slots);
+    factory->slots = slots;
+    factory->mask = mask;
+}
+
+/*
+ * Gets the unique node with the token and children, creating it if the factory has not seen it before.
+ */
+tree_node* factory_node(formula_factory* factory, token token, tree_node* left_child, tree_node* right_child)
+{
+    unsigned int hash = factory_hash(token, left_child, right_child);
+    size_t slot = hash & factory->mask;
+
+    for (; factory->slots[slot].node != NULL; slot = (slot + 1) & factory->mask)
+    {
+        tree_node* node = factory->slots[slot].node;
+        if (factory->slots[slot].hash == hash && node->left_child == left_child && node->right_child == right_child &&
+            equals(node->token, token))
+        {
+            return node; // the formula already exists.
+        }
+    }
+
+    tree_node* node = (tree_node*)arena_alloc(factory->arena, sizeof(tree_node));
+    node->token = token;
+    node->left_child = left_child;
+    node->right_child = right_child;
+    node->hash = hash;
+    node->index = (unsigned int)factory->size++;
+    node->variable = token.type == proposition ? (unsigned int)factory->propositions++ : 0;
+    factory->slots[slot].hash = hash;
+    factory->slots[slot].node = node;
+
+    // Keep the load factor of the hash table at most one half.
+    if (2 * factory->size > factory->mask + 1)
+    {
+        factory_grow(factory);
+    }
+
+    return node;
+}
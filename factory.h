@@ -0,0 +1,37 @@
+#ifndef THEOREMPROVER_FACTORY_H
+#define THEOREMPROVER_FACTORY_H
+
+#include <stddef.h>
+#include "token.h"
+#include "arena.h"
+
+typedef struct tree_node tree_node;
+
+/*
+ * Formula factory hash-conses formulas: it owns every node it creates and returns the existing node when a node with
+ * the same token and the same children is requested again. Identical subformulas therefore share one node and two
+ * formulas from the same factory are equal if and only if they are the same pointer.
+ * All nodes stay alive until the factory is freed, so the factory acts as the owner of the formulas of a proof.
+ */
+typedef struct factory_slot
+{
+    unsigned int hash;
+    tree_node* node;
+} factory_slot;
+
+typedef struct formula_factory
+{
+    factory_slot* slots; // open addressing hash table of nodes (the hashes are kept in the table to avoid touching nodes).
+    size_t mask;         // number of slots minus one (the number of slots is a power of two).
+    size_t size;         // number of distinct nodes.
+    size_t propositions; // number of distinct propositions (the variables of the formulas of the factory).
+    arena* arena;        // nodes are allocated from the arena and released together with the factory.
+} formula_factory;
+
+formula_factory* factory_create();
+
+void factory_free(formula_factory* factory);
+
+tree_node* factory_node(formula_factory* factory, token token, tree_node* left_child, tree_node* right_child);
+
+#endif //THEOREMPROVER_FACTORY_H
@@ -0,0 +1,224 @@
+#include "flat.h"
+#include "tokenizer.h"
+#include "stack.h"
+
+#include <stdlib.h>
+
+/*
+ * Token types and connectives as they are packed into the tag of a flat node.
+ */
+enum flat_kind
+{
+    flat_proposition_kind = 0,
+    flat_negation_kind = 1,
+    flat_binary_kind = 2
+};
+
+static const char flat_connectives[3] = { '^', 'v', '>' };
+
+/*
+ * Gets the token type bits of a tag.
+ */
+static inline uint32_t flat_kind(uint32_t tag)
+{
+    return tag & 3;
+}
+
+/*
+ * Packs a token into a tag.
+ */
+static uint32_t flat_tag(token token)
+{
+    switch (token.type)
+    {
+        case proposition:
+            return flat_proposition_kind | ((uint32_t)token.id << 4);
+        case negation:
+            return flat_negation_kind;
+        default:
+            if (is_and_connective(token.symbol)) { return flat_binary_kind; }
+            if (is_or_connective(token.symbol)) { return flat_binary_kind | (1 << 2); }
+            return flat_binary_kind | (2 << 2);
+    }
+}
+
+/*
+ * Initializes an empty flat formula.
+ */
+void flat_init(flat_formula* flat)
+{
+    flat->nodes = NULL;
+    flat->size = 0;
+    flat->capacity = 0;
+}
+
+/*
+ * Frees the nodes of the flat formula (the flat formula itself is owned by the caller).
+ */
+void flat_destroy(flat_formula* flat)
+{
+    free(flat->nodes);
+    flat_init(flat);
+}
+
+/*
+ * Makes room for size nodes. The capacity is doubled in a size_t and capped at the largest uint32_t, so the doubling
+ * ends for any size.
+ */
+static void flat_reserve(flat_formula* flat, uint32_t size)
+{
+    if (size > flat->capacity)
+    {
+        size_t capacity = flat->capacity == 0 ? 64 : flat->capacity;
+        while (capacity < size) { capacity *= 2; }
+        if (capacity > UINT32_MAX) { capacity = UINT32_MAX; }
+
+        flat->nodes = (flat_node*)realloc(flat->nodes, capacity * sizeof(flat_node));
+        flat->capacity = (uint32_t)capacity;
+    }
+}
+
+/*
+ * Appends a node to the end of the flat formula and returns its index.
+ */
+static uint32_t flat_push(flat_formula* flat, uint32_t tag, uint32_t span)
+{
+    flat_reserve(flat, flat->size + 1);
+    flat->nodes[flat->size].tag = tag;
+    flat->nodes[flat->size].span = span;
+    return flat->size++;
+}
+
+/*
+ * Unpacks the token of the node at the index.
+ */
+static token flat_token(const flat_formula* flat, uint32_t index)
+{
+    token token;
+    uint32_t tag = flat->nodes[index].tag;
+
+    switch (flat_kind(tag))
+    {
+        case flat_proposition_kind:
+            token_init_proposition(&token, (int)(tag >> 4));
+            break;
+        case flat_negation_kind:
+            token_init(&token, negation, '-');
+            break;
+        default:
+            token_init(&token, binary_connective, flat_connectives[(tag >> 2) & 3]);
+            break;
+    }
+
+    return token;
+}
+
+/*
+ * Gets the index of the left operand of the binary formula at the index (its right operand is at index - 1).
+ */
+static uint32_t flat_left(const flat_formula* flat, uint32_t index)
+{
+    return index - 1 - flat->nodes[index - 1].span;
+}
+
+/*
+ * Flattens a formula (a shared subformula is stored once for every occurrence). The flat formula is cleared first.
+ */
+void flat_from_tree(flat_formula* flat, tree_node* formula)
+{
+    flat->size = 0;
+    if (formula != NULL) { flat_append_tree(flat, formula); }
+}
+
+/*
+ * Appends a formula after the formulas already in the flat formula and returns the index of its root, so several
+ * formulas (the formulas of a theory) can be stored in one array. Uses an iterative post-order traversal: each stack
+ * entry is a node and whether its operands have been emitted.
+ */
+uint32_t flat_append_tree(flat_formula* flat, tree_node* formula)
+{
+    stack pending;
+    stack_init(&pending);
+    stack_push(&pending, formula);
+    stack_push(&pending, (void*)0);
+
+    while (!stack_empty(&pending))
+    {
+        bool expanded = stack_pop(&pending) != NULL;
+        tree_node* node = (tree_node*)stack_pop(&pending);
+
+        if (!expanded && node->left_child != NULL)
+        {
+            stack_push(&pending, node);
+            stack_push(&pending, (void*)1);
+            if (node->right_child != NULL)
+            {
+                stack_push(&pending, node->right_child);
+                stack_push(&pending, (void*)0);
+            }
+            stack_push(&pending, node->left_child);
+            stack_push(&pending, (void*)0);
+            continue;
+        }
+
+        // The operands have been emitted, so the span follows from the spans of the nodes just before this one.
+        uint32_t span = 1;
+        if (node->left_child != NULL)
+        {
+            uint32_t right_span = flat->nodes[flat->size - 1].span;
+            span += right_span;
+            if (node->right_child != NULL)
+            {
+                span += flat->nodes[flat->size - 1 - right_span].span;
+            }
+        }
+
+        flat_push(flat, flat_tag(node->token), span);
+    }
+
+    stack_destroy(&pending);
+    return flat->size - 1;
+}
+
+/*
+ * Builds the formula in the factory with a single linear scan: the operands of every node precede it.
+ */
+tree_node* flat_to_tree(formula_factory* factory, const flat_formula* flat)
+{
+    if (flat->size == 0) { return NULL; }
+
+    uint32_t root = flat->size - 1;
+    tree_node* formula;
+    flat_to_trees(factory, flat, &root, 1, &formula);
+    return formula;
+}
+
+/*
+ * Builds the formulas rooted at the given indices (returned by flat_append_tree) in the factory with a single linear
+ * scan, storing each in formulas. The factory shares the subformulas that occur several times again.
+ */
+void flat_to_trees(formula_factory* factory, const flat_formula* flat, const uint32_t* roots, size_t count,
+                   tree_node** formulas)
+{
+    tree_node** nodes = (tree_node**)malloc(((size_t)flat->size + 1) * sizeof(tree_node*));
+
+    for (uint32_t i = 0; i < flat->size; ++i)
+    {
+        token token = flat_token(flat, i);
+        switch (token.type)
+        {
+            case proposition:
+                nodes[i] = proposition_formula(factory, token);
+                break;
+            case negation:
+                nodes[i] = negated_formula(factory, token, nodes[i - 1]);
+                break;
+            default:
+                nodes[i] = binary_formula(factory, token, nodes[flat_left(flat, i)], nodes[i - 1]);
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) { formulas[i] = nodes[roots[i]]; }
+    free(nodes);
+}
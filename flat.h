@@ -0,0 +1,48 @@
+#ifndef THEOREMPROVER_FLAT_H
+#define THEOREMPROVER_FLAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "token.h"
+#include "tree.h"
+
+/*
+ * Flat formula node: a packed token tag and the number of nodes in the subformula rooted at the node.
+ * Tag bits 0-1 hold the token type (proposition, negation or binary connective), bits 2-3 the connective
+ * (and, or, implies) and bits 4-31 the proposition id.
+ */
+typedef struct flat_node
+{
+    uint32_t tag;
+    uint32_t span;
+} flat_node;
+
+/*
+ * Flat formula stores the nodes of a formula contiguously in post-order, so the root is the last node and every
+ * subformula occupies a contiguous range of nodes ending at its root. Children are found from relative offsets:
+ * the operand of a negation and the right operand of a binary formula are at offset 1, and the left operand of a
+ * binary formula is at offset 1 + span of the right operand. The encoding contains no pointers, so a flat formula can
+ * be copied with memcpy (between threads), and traversals are linear scans of the array. Several formulas
+ * can follow each other in one array, each found by the index of its root.
+ */
+typedef struct flat_formula
+{
+    flat_node* nodes;
+    uint32_t size;
+    uint32_t capacity;
+} flat_formula;
+
+void flat_init(flat_formula* flat);
+
+void flat_destroy(flat_formula* flat);
+
+void flat_from_tree(flat_formula* flat, tree_node* formula);
+
+uint32_t flat_append_tree(flat_formula* flat, tree_node* formula);
+
+tree_node* flat_to_tree(formula_factory* factory, const flat_formula* flat);
+
+void flat_to_trees(formula_factory* factory, const flat_formula* flat, const uint32_t* roots, size_t count,
+                   tree_node** formulas);
+
+#endif //THEOREMPROVER_FLAT_H
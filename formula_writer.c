@@ -1,69 +1,121 @@
-#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "formula_writer.h"
 #include "tree.h"
+#include "symbol_table.h"
+#include "stack.h"
 
 /*
  * Calculates the number of characters required to represent the formula as a character array.
+ * Every node contributes a fixed number of characters so the nodes can be visited in any order with an explicit stack.
  */
-int formula_length(tree_node* node)
+size_t formula_length(tree_node* node)
 {
-    if (node != NULL)
+    stack pending;
+    stack_init(&pending);
+    size_t length = 0;
+
+    while (node != NULL)
     {
         switch (node->token.type)
         {
             case proposition:
-                return 1;
+                length += symbol_length(node->token.id);
+                break;
             case negation:
-                return 1 + formula_length(node->left_child);
+                length += 1;
+                break;
             case binary_connective:
-                return 3 + formula_length(node->left_child) + formula_length(node->right_child);
+                length += 3;
+                stack_push(&pending, node->right_child);
+                break;
             default:
-                exit(1);
+                break; // a formula tree has no other tokens.
+        }
+
+        node = node->left_child;
+        if (node == NULL)
+        {
+            node = (tree_node*)stack_pop(&pending);
         }
     }
 
-    return 0;
+    stack_destroy(&pending);
+    return length;
 }
 
 /*
- * Appends a character to the end of the character array.
+ * Infix writer states: a binary node is visited before its left subtree, between its subtrees and after its right subtree.
  */
-void append(char** s, char c)
+typedef enum infix_state
 {
-    char* t = *s;
-    size_t n = strlen(t);
-    t[n++] = c;
-    t[n] = '\0';
-}
+    infix_before,
+    infix_between,
+    infix_after
+} infix_state;
 
 /*
  * Converts the propositional formula represented as a binary tree to a character array in infix notation.
+ * The formula is appended to the string, which must have room for formula_length(node) more characters.
+ * The stack holds pairs of a node and the state the node is in.
  */
 void infix(tree_node* node, char** formula)
 {
+    char* out = *formula + strlen(*formula);
+    stack pending;
+    stack_init(&pending);
+
     if (node != NULL)
     {
+        stack_push(&pending, node);
+        stack_push(&pending, (void*)(intptr_t)infix_before);
+    }
+
+    while (!stack_empty(&pending))
+    {
+        infix_state state = (infix_state)(intptr_t)stack_pop(&pending);
+        node = (tree_node*)stack_pop(&pending);
         token token = node->token;
+
         switch (token.type)
         {
             case proposition:
-                append(formula, token.symbol);
+                memcpy(out, symbol_name(token.id), symbol_length(token.id));
+                out += symbol_length(token.id);
                 break;
             case negation:
-                append(formula, token.symbol);
-                infix(node->left_child, formula);
+                *out++ = token.symbol;
+                stack_push(&pending, node->left_child);
+                stack_push(&pending, (void*)(intptr_t)infix_before);
                 break;
             case binary_connective:
-                append(formula, '(');
-                infix(node->left_child, formula);
-                append(formula, token.symbol);
-                infix(node->right_child, formula);
-                append(formula, ')');
+                if (state == infix_before)
+                {
+                    *out++ = '(';
+                    stack_push(&pending, node);
+                    stack_push(&pending, (void*)(intptr_t)infix_between);
+                    stack_push(&pending, node->left_child);
+                    stack_push(&pending, (void*)(intptr_t)infix_before);
+                }
+                else if (state == infix_between)
+                {
+                    *out++ = token.symbol;
+                    stack_push(&pending, node);
+                    stack_push(&pending, (void*)(intptr_t)infix_after);
+                    stack_push(&pending, node->right_child);
+                    stack_push(&pending, (void*)(intptr_t)infix_before);
+                }
+                else
+                {
+                    *out++ = ')';
+                }
                 break;
             default:
-                return;
+                break;
         }
     }
-}
\ No newline at end of file
+
+    *out = '\0';
+    stack_destroy(&pending);
+}
@@ -1,11 +1,11 @@
 #ifndef THEOREMPROVER_FORMULA_WRITER_H
 #define THEOREMPROVER_FORMULA_WRITER_H
 
-typedef struct tree_node tree_node;
+#include <stddef.h>
 
-int formula_length(tree_node* node);
+typedef struct tree_node tree_node;
 
-void append(char** s, char c);
+size_t formula_length(tree_node* node);
 
 void infix(tree_node* node, char** formula);
 
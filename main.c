@@ -4,17 +4,31 @@
 
 #include "parser.h"
 #include "formula_writer.h"
-#include "tableaux.h"
+#include "prover.h"
+#include "batch.h"
+#include "smtlib.h"
+#include "cache.h"
+#include "portfolio.h"
 
-int max_len = 256; // maximum length of formulas.
+/*
+ * Reads a one character response and discards the rest of the line (EOF if the input has ended).
+ */
+int read_response()
+{
+    int response = fgetc(stdin);
+    int c = response;
+    while (c != '\n' && c != EOF) { c = fgetc(stdin); }
+    return response;
+}
 
 /*
- * Parses the input formula and runs the tableau theorem prover algorithm to test for satisfiability/validity.
+ * Parses the input formula and runs the theorem prover engine of the options to test for satisfiability/validity.
  */
-void theorem_prover(char* formula)
+void theorem_prover(char* formula, const prover_options* options)
 {
     // parse the input formula.
-    tree_node* node = parse(formula);
+    formula_factory* factory = factory_create();
+    tree_node* node = parse(factory, formula);
 
     if (node != NULL)
     {
@@ -30,8 +44,8 @@ void theorem_prover(char* formula)
                 printf("%s is a negation.\n", formula);
                 break;
             case binary_connective:
-                left = (char*)malloc(formula_length(node->left_child) * sizeof(char));
-                right = (char*)malloc(formula_length(node->right_child) * sizeof(char));
+                left = (char*)malloc((formula_length(node->left_child) + 1) * sizeof(char));
+                right = (char*)malloc((formula_length(node->right_child) + 1) * sizeof(char));
                 left[0] = right[0] = '\0';
                 infix(node->left_child, &left);
                 infix(node->right_child, &right);
@@ -40,63 +54,344 @@ void theorem_prover(char* formula)
                 free(right);
                 break;
             default:
-                exit(1);
+                break; // a parsed formula has no other tokens.
         }
 
         // run the tableau theorem prover algorithm.
         bool check_validity = false;
         printf("Check Valid or Satisfiable? (v/s):\n");
-        char response = (char)fgetc(stdin);
-        if (response == 'v') { check_validity = true; }
-        while (fgetc(stdin) != '\n');
+        if (read_response() == 'v') { check_validity = true; }
 
+        prover_model model;
         if (check_validity)
         {
-            bool valid = is_valid(node); // test the formula for validity.
-            if (valid)
+            prover_result falsifiable = falsifying_model(factory, node, options, &model, NULL); // test for validity.
+            if (falsifiable == result_false)
             {
                 printf("%s is valid.\n", formula);
             }
+            else if (falsifiable == result_unknown)
+            {
+                printf("%s could not be decided within the limits.\n", formula);
+            }
             else
             {
                 printf("%s is not valid.\n", formula);
+                printf("Counterexample: ");
+                prover_model_print(&model, stdout);
+                printf("\n");
             }
         }
         else
         {
-            bool satisfiable = is_satisfiable(node); // test the formula for satisfiability.
-            if (satisfiable)
+            prover_result satisfiable = satisfying_model(factory, node, options, &model, NULL); // test satisfiability.
+            if (satisfiable == result_unknown)
+            {
+                printf("%s could not be decided within the limits.\n", formula);
+            }
+            else if (satisfiable == result_true)
             {
                 printf("%s is satisfiable.\n", formula);
+                printf("Model: ");
+                prover_model_print(&model, stdout);
+                printf("\n");
             }
             else
             {
                 printf("%s is not satisfiable.\n", formula);
             }
         }
+
+        prover_model_free(&model);
     }
     else
     {
         printf("%s is not a propositional formula.\n", formula);
     }
+
+    factory_free(factory);
+}
+
+/*
+ * Prints the command line usage.
+ */
+void usage(const char* program)
+{
+    fprintf(stderr, "usage: %s                                                    interactive mode\n", program);
+    fprintf(stderr, "       %s --batch (sat|valid|count|equiv) [--stats] [--model] [--jobs N] [file]  check every "
+            "line of the file (or stdin)\n", program);
+    fprintf(stderr, "       %s --dimacs [file]                                 check a DIMACS CNF file (or stdin)\n",
+            program);
+    fprintf(stderr, "       %s --smt2 [file]                                   run an SMT-LIB 2 script (or stdin)\n",
+            program);
+    fprintf(stderr, "the other modes accept --engine (tableau|cdcl|dfs|parallel|truth-table|bdd|portfolio|automatic) "
+            "to select the decision procedure (default automatic)\n");
+    fprintf(stderr, "and --threads N to set the threads of the parallel engine (default 0, one per processor)\n");
+    fprintf(stderr, "--jobs N checks the lines of a batch on N worker threads (default 1, 0 for one per processor), "
+            "writing the results in input order\n");
+    fprintf(stderr, "--max-expansions N, --timeout SECONDS and --max-bytes N limit each query, which is unknown when a "
+            "limit is reached\n");
+    fprintf(stderr, "--select (alpha-first|smallest-beta|moms|random) sets the formula selection of the tableau "
+            "engines (default alpha-first),\n");
+    fprintf(stderr, "--seed N the seed of the random selection (default 0) and --branching "
+            "(syntactic|semantic|variable) their beta rule (default syntactic)\n");
+    fprintf(stderr, "--cache N keeps the verdicts of up to N formulas for the queries that follow (in the batch and "
+            "interactive modes)\n");
+    fprintf(stderr, "--bdd-order (appearance|frequency|id) sets the variable order of the BDDs (default appearance)\n");
+    fprintf(stderr, "--table-variables N makes the automatic engine decide the formulas with at most N propositions by "
+            "their truth table and the others by the tableau (default 16, 0 for none)\n");
+    fprintf(stderr, "--portfolio ENGINE,... sets the engines raced on threads by the portfolio engine, whose first "
+            "verdict wins (default tableau,dfs,cdcl,bdd)\n");
+}
+
+/*
+ * Parses a positive number option value, returning false if it is not one.
+ */
+bool parse_number(const char* text, double max, double* value)
+{
+    char* end;
+    *value = strtod(text, &end);
+    return *text != '\0' && *end == '\0' && *value > 0 && *value <= max;
+}
+
+/*
+ * Removes the prover options (--engine NAME, --threads N, the limits, --select NAME, --seed N, --branching NAME,
+ * --cache N, --table-variables N, --bdd-order NAME and --portfolio NAMES) from the arguments and stores them in the
+ * options. Returns false if an option value is missing or invalid.
+ */
+bool parse_options(int* argc, char** argv, prover_options* options)
+{
+    int count = 1;
+
+    for (int i = 1; i < *argc; ++i)
+    {
+        if (strcmp(argv[i], "--engine") == 0)
+        {
+            if (i + 1 == *argc || !prover_engine_parse(argv[i + 1], &options->engine)) { return false; }
+            ++i;
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            char* end;
+            if (i + 1 == *argc) { return false; }
+            long threads = strtol(argv[i + 1], &end, 10);
+            if (*argv[i + 1] == '\0' || *end != '\0' || threads < 0 || threads > 4096) { return false; }
+            options->threads = (int)threads;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--select") == 0)
+        {
+            if (i + 1 == *argc || !selection_parse(argv[i + 1], &options->selection)) { return false; }
+            ++i;
+        }
+        else if (strcmp(argv[i], "--branching") == 0)
+        {
+            if (i + 1 == *argc || !branching_parse(argv[i + 1], &options->branching)) { return false; }
+            ++i;
+        }
+        else if (strcmp(argv[i], "--bdd-order") == 0)
+        {
+            if (i + 1 == *argc || !bdd_ordering_parse(argv[i + 1], &options->ordering)) { return false; }
+            ++i;
+        }
+        else if (strcmp(argv[i], "--portfolio") == 0)
+        {
+            if (i + 1 == *argc || !portfolio_parse(argv[i + 1], options->portfolio, &options->portfolio_size))
+            {
+                return false;
+            }
+            ++i;
+        }
+        else if (strcmp(argv[i], "--table-variables") == 0)
+        {
+            char* end;
+            if (i + 1 == *argc) { return false; }
+            long variables = strtol(argv[i + 1], &end, 10);
+            if (*argv[i + 1] == '\0' || *end != '\0' || variables < 0 || variables > 62) { return false; }
+            options->table_variables = (int)variables;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            char* end;
+            if (i + 1 == *argc) { return false; }
+            unsigned long long seed = strtoull(argv[i + 1], &end, 10);
+            if (*argv[i + 1] == '\0' || *argv[i + 1] == '-' || *end != '\0') { return false; }
+            options->seed = (uint64_t)seed;
+            ++i;
+        }
+        else if (strcmp(argv[i], "--cache") == 0)
+        {
+            double capacity;
+            if (i + 1 == *argc || !parse_number(argv[i + 1], 1e9, &capacity)) { return false; }
+            if (options->cache != NULL) { result_cache_free(options->cache); }
+            options->cache = result_cache_create((size_t)capacity);
+            ++i;
+        }
+        else if (strcmp(argv[i], "--max-expansions") == 0 || strcmp(argv[i], "--max-bytes") == 0 ||
+                 strcmp(argv[i], "--timeout") == 0)
+        {
+            double value;
+            if (i + 1 == *argc || !parse_number(argv[i + 1], 1e18, &value)) { return false; }
+
+            if (strcmp(argv[i], "--timeout") == 0) { options->limits.max_seconds = value; }
+            else if (strcmp(argv[i], "--max-bytes") == 0) { options->limits.max_bytes = (size_t)value; }
+            else { options->limits.max_expansions = (long)value; }
+            ++i;
+        }
+        else
+        {
+            argv[count++] = argv[i];
+        }
+    }
+
+    *argc = count;
+    return true;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    prover_options options;
+    prover_options_init(&options);
+    if (!parse_options(&argc, argv, &options))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--dimacs") == 0)
+    {
+        // DIMACS mode: stream the clauses of a CNF file into a theory and check it for satisfiability (a single query,
+        // so there is nothing to cache).
+        if (argc > 3 || options.cache != NULL)
+        {
+            if (options.cache != NULL) { result_cache_free(options.cache); }
+            usage(argv[0]);
+            return 2;
+        }
+
+        int result = batch_dimacs(argc == 3 ? argv[2] : NULL, &options, stdout);
+        return result < 0 ? 1 : result;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--smt2") == 0)
+    {
+        // SMT-LIB mode: answer the commands of a script incrementally (the engine options and the cache do not apply).
+        if (argc > 3 || options.cache != NULL)
+        {
+            if (options.cache != NULL) { result_cache_free(options.cache); }
+            usage(argv[0]);
+            return 2;
+        }
+
+        return smtlib_run(argc == 3 ? argv[2] : NULL, stdout) != 0 ? 1 : 0;
+    }
+
+    if (argc > 1)
+    {
+        // batch mode: apply one query to every formula in the input without prompting.
+        if (strcmp(argv[1], "--batch") != 0 || argc < 3)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        query_type query;
+        if (strcmp(argv[2], "sat") == 0)
+        {
+            query = query_satisfiable;
+        }
+        else if (strcmp(argv[2], "valid") == 0)
+        {
+            query = query_valid;
+        }
+        else if (strcmp(argv[2], "count") == 0)
+        {
+            query = query_count;
+        }
+        else if (strcmp(argv[2], "equiv") == 0)
+        {
+            query = query_equivalent;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        const char* path = NULL;
+        bool stats = false;
+        bool model = false;
+        int jobs = 1;
+        for (int i = 3; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--stats") == 0)
+            {
+                stats = true;
+            }
+            else if (strcmp(argv[i], "--jobs") == 0)
+            {
+                // the number of worker threads that check the lines concurrently (0 for one per processor).
+                char* end = NULL;
+                long count = -1; // a missing value is invalid.
+                if (i + 1 < argc) { count = strtol(argv[i + 1], &end, 10); }
+                if (count < 0 || count > 4096 || *argv[i + 1] == '\0' || *end != '\0')
+                {
+                    usage(argv[0]);
+                    return 2;
+                }
+
+                jobs = (int)count;
+                ++i;
+            }
+            else if (strcmp(argv[i], "--model") == 0)
+            {
+                model = true;
+            }
+            else if (path == NULL)
+            {
+                path = argv[i];
+            }
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+
+        // the queries share one BDD manager, so the BDDs of common subformulas are built once.
+        if (options.engine == engine_bdd || query == query_equivalent)
+        {
+            options.bdd = bdd_manager_create(options.ordering);
+        }
+
+        int errors = batch_run(path, query, &options, stats, model, jobs, stdout);
+        if (options.cache != NULL) { result_cache_free(options.cache); }
+        if (options.bdd != NULL) { bdd_manager_free(options.bdd); }
+        return errors < 0 ? 1 : 0;
+    }
+
+    char* formula = NULL;
+    size_t capacity = 0;
+    if (options.engine == engine_bdd) { options.bdd = bdd_manager_create(options.ordering); }
+
     while (true)
     {
-        // get the user input.
-        char formula[max_len];
+        // get the user input (of any length).
         printf("Enter propositional formula:\n");
-        fgets(formula, max_len, stdin);
-        formula[strcspn(formula, "\n")] = 0;
+        if (getline(&formula, &capacity, stdin) == -1) { break; }
+        formula[strcspn(formula, "\r\n")] = 0;
 
-        theorem_prover(formula); // parse formula, build tableau and run the tableau theorem prover.
+        theorem_prover(formula, &options); // parse formula, build tableau and run the tableau theorem prover.
 
         // ask user if they want to exit the program.
         printf("Want to exit? (y/n)\n");
-        char response = (char)fgetc(stdin);
-        if (response == 'y') { break; }
-        while (fgetc(stdin) != '\n');
+        int response = read_response();
+        if (response == 'y' || response == EOF) { break; }
     }
+
+    free(formula);
+    if (options.cache != NULL) { result_cache_free(options.cache); }
+    if (options.bdd != NULL) { bdd_manager_free(options.bdd); }
+    return 0;
 }
\ No newline at end of file
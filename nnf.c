@@ -0,0 +1,186 @@
+#include "nnf.h"
+#include "tokenizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * NNF frame is a subformula waiting for the conversion of its operands with the polarity it occurs in.
+ */
+typedef struct nnf_frame
+{
+    tree_node* formula;
+    bool negated;
+} nnf_frame;
+
+/*
+ * Initializes a converter for the formulas of the factory.
+ */
+void nnf_init(nnf_converter* converter, formula_factory* factory)
+{
+    converter->factory = factory;
+    converter->count = factory->size;
+    converter->results = (tree_node**)calloc(2 * converter->count + 1, sizeof(tree_node*));
+}
+
+/*
+ * Frees the remembered results (the converted formulas are owned by the factory).
+ */
+void nnf_destroy(nnf_converter* converter)
+{
+    free(converter->results);
+    converter->results = NULL;
+    converter->count = 0;
+}
+
+/*
+ * Gets the slot of the converted subformula for a node and polarity, covering the nodes created in the factory since
+ * the converter was initialized when needed.
+ */
+static tree_node** nnf_result(nnf_converter* converter, tree_node* formula, bool negated)
+{
+    size_t index = formula->index;
+    if (index >= converter->count)
+    {
+        size_t count = converter->factory->size;
+        converter->results = (tree_node**)realloc(converter->results, (2 * count + 1) * sizeof(tree_node*));
+        memset(converter->results + 2 * converter->count, 0, 2 * (count - converter->count) * sizeof(tree_node*));
+        converter->count = count;
+    }
+
+    return &converter->results[2 * index + (negated ? 1 : 0)];
+}
+
+/*
+ * Converts a formula (or its negation if negated is set) into negation normal form:
+ *   -p stays a literal, --A becomes A,
+ *   (A ^ B) and -(A v B) become conjunctions of the converted operands (-A ^ -B for the negated disjunction),
+ *   (A v B), (A > B) ≡ (-A v B) and -(A ^ B) ≡ (-A v -B) become disjunctions,
+ *   -(A > B) ≡ (A ^ -B) becomes a conjunction.
+ * The traversal is iterative, so arbitrarily deep formulas are converted without recursion.
+ */
+tree_node* nnf_convert(nnf_converter* converter, tree_node* formula, bool negated)
+{
+    tree_node** result = nnf_result(converter, formula, negated);
+    if (*result != NULL) { return *result; }
+
+    formula_factory* factory = converter->factory;
+    token and_token, or_token, negation_token;
+    token_init(&and_token, binary_connective, '^');
+    token_init(&or_token, binary_connective, 'v');
+    token_init(&negation_token, negation, '-');
+
+    size_t size = 0;
+    size_t capacity = 64;
+    nnf_frame* frames = (nnf_frame*)malloc(capacity * sizeof(nnf_frame));
+    frames[size++] = (nnf_frame){ formula, negated };
+
+    while (size > 0)
+    {
+        nnf_frame frame = frames[size - 1];
+        tree_node* node = frame.formula;
+        result = nnf_result(converter, node, frame.negated);
+
+        if (*result != NULL)
+        {
+            --size; // already converted through another occurrence of the subformula.
+            continue;
+        }
+
+        if (node->token.type == proposition)
+        {
+            *result = frame.negated ? negated_formula(factory, negation_token, node) : node;
+            --size;
+            continue;
+        }
+
+        // Operands and their polarities: negations flip the polarity and implications flip it for the left operand.
+        tree_node* left = node->left_child;
+        tree_node* right = node->right_child;
+        bool left_negated = frame.negated;
+        bool right_negated = frame.negated;
+        bool conjunction = false;
+
+        if (node->token.type == negation)
+        {
+            left_negated = !frame.negated;
+        }
+        else if (is_and_connective(node->token.symbol))
+        {
+            conjunction = !frame.negated;
+        }
+        else if (is_or_connective(node->token.symbol))
+        {
+            conjunction = frame.negated;
+        }
+        else
+        {
+            left_negated = !frame.negated;
+            conjunction = frame.negated;
+        }
+
+        tree_node* left_result = *nnf_result(converter, left, left_negated);
+        tree_node* right_result = right != NULL ? *nnf_result(converter, right, right_negated) : NULL;
+
+        if (left_result != NULL && (right == NULL || right_result != NULL))
+        {
+            // Every operand has been converted, so the subformula can be built.
+            if (right == NULL)
+            {
+                *result = left_result;
+            }
+            else
+            {
+                *result = binary_formula(factory, conjunction ? and_token : or_token, left_result, right_result);
+            }
+
+            --size;
+            continue;
+        }
+
+        if (size + 2 > capacity)
+        {
+            capacity *= 2;
+            frames = (nnf_frame*)realloc(frames, capacity * sizeof(nnf_frame));
+        }
+
+        // The right operand is pushed first so that the left operand is converted first.
+        if (right != NULL && right_result == NULL) { frames[size++] = (nnf_frame){ right, right_negated }; }
+        if (left_result == NULL) { frames[size++] = (nnf_frame){ left, left_negated }; }
+    }
+
+    free(frames);
+    return *nnf_result(converter, formula, negated);
+}
+
+/*
+ * Converts a single formula (or its negation if negated is set) into negation normal form.
+ */
+tree_node* nnf_formula(formula_factory* factory, tree_node* formula, bool negated)
+{
+    nnf_converter converter;
+    nnf_init(&converter, factory);
+    tree_node* result = nnf_convert(&converter, formula, negated);
+    nnf_destroy(&converter);
+    return result;
+}
+
+/*
+ * Creates a theory allocated from the arena with the negation normal form of every formula of a theory. Formulas of
+ * the theory that share subformulas are converted with the same converter, so shared subformulas are only converted
+ * once. The original theory is left unchanged.
+ */
+theory* nnf_theory(formula_factory* factory, arena* arena, theory* set)
+{
+    nnf_converter converter;
+    nnf_init(&converter, factory);
+
+    theory* converted = theory_create(arena);
+    for (theory_node* node = theory_first(set); node != NULL; node = theory_next(set, node))
+    {
+        theory_push(converted, nnf_convert(&converter, node->formula, false));
+    }
+
+    nnf_destroy(&converter);
+    return converted;
+}
@@ -0,0 +1,32 @@
+#ifndef THEOREMPROVER_NNF_H
+#define THEOREMPROVER_NNF_H
+
+#include <stdbool.h>
+#include "tree.h"
+#include "theory.h"
+
+/*
+ * Negation normal form converter rewrites formulas into equivalent formulas built from literals, conjunctions and
+ * disjunctions only (negations are pushed down to the propositions and implications are replaced by disjunctions).
+ * The result for every subformula and polarity is remembered, so formulas that share subformulas in the factory are
+ * converted once per polarity and the results share nodes in the same way (the conversion is linear in the number of
+ * distinct nodes).
+ */
+typedef struct nnf_converter
+{
+    formula_factory* factory;
+    tree_node** results; // converted subformula for each node index and polarity (index * 2 + negated).
+    size_t count;        // number of factory nodes covered by the results.
+} nnf_converter;
+
+void nnf_init(nnf_converter* converter, formula_factory* factory);
+
+void nnf_destroy(nnf_converter* converter);
+
+tree_node* nnf_convert(nnf_converter* converter, tree_node* formula, bool negated);
+
+tree_node* nnf_formula(formula_factory* factory, tree_node* formula, bool negated);
+
+theory* nnf_theory(formula_factory* factory, arena* arena, theory* set);
+
+#endif //THEOREMPROVER_NNF_H
@@ -0,0 +1,398 @@
+#include "parallel.h"
+#include "tableaux.h"
+#include "arena.h"
+#include "nnf.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const size_t spawn_limit = 4; // a worker only spawns tasks while its deque holds fewer tasks than this.
+
+/*
+ * Parallel task is a branch of the tableau waiting to be searched, given by the formulas of its theory. The formulas
+ * belong to the factory, which is not changed during the search, so a task can be searched by any worker.
+ */
+typedef struct parallel_task
+{
+    size_t count;
+    tree_node* formulas[];
+} parallel_task;
+
+/*
+ * Parallel deque holds the tasks of one worker. The worker pushes and pops its tasks at the back (depth-first), and
+ * idle workers steal from the front the oldest tasks, which are closest to the root and tend to be the largest.
+ */
+typedef struct parallel_deque
+{
+    pthread_mutex_t lock;
+    parallel_task** tasks;
+    size_t front;
+    size_t back;
+    size_t capacity;
+} parallel_deque;
+
+typedef struct parallel_search parallel_search;
+
+/*
+ * Parallel worker searches tasks depth-first on its own thread with its own proof arena and statistics.
+ */
+typedef struct parallel_worker
+{
+    parallel_search* search;
+    size_t id;
+    pthread_t thread;
+    bool started;       // the worker runs on a thread of its own (worker 0 runs on the calling thread).
+    parallel_deque deque;
+    arena* proof;
+    budget budget;      // share of the limits of the query.
+    selection selection; // copy of the selection of the query with a random stream of its own.
+    prover_stats stats;
+} parallel_worker;
+
+/*
+ * Parallel search is shared by the workers of one query. Its flags and counters are accessed atomically. A worker that
+ * finds no task to steal sleeps on the condition variable until a task is spawned, every task has been searched or the
+ * search stops, instead of spinning while the busy workers need the processors.
+ */
+struct parallel_search
+{
+    parallel_worker* workers;
+    size_t count;
+    bool satisfiable;   // set by the worker that finds an open branch.
+    bool exhausted;     // set by a worker whose budget runs out.
+    bool stop;          // set with either flag, which cancels every worker.
+    size_t pending;     // tasks that have been created and not searched yet.
+    size_t spawned;     // number of tasks spawned so far, which tells a sleeping worker that there may be work.
+    size_t idle;        // workers sleeping (or about to sleep) on the condition variable.
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool* valuation;    // filled from the open branch by the worker that sets the satisfiable flag (may be NULL).
+    branching branching; // branching rule of the query (read only during the search).
+};
+
+/*
+ * Gets the number of worker threads for a thread count option (0 selects one thread per online processor).
+ */
+int parallel_thread_count(int threads)
+{
+    if (threads > 0) { return threads; }
+
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? (int)processors : 1;
+}
+
+/*
+ * Creates a task from the formulas of a theory and the extra formulas that are not NULL, pushed after them.
+ */
+static parallel_task* parallel_task_create(theory* set, tree_node* first, tree_node* second)
+{
+    size_t count = (first != NULL ? 1 : 0) + (second != NULL ? 1 : 0);
+    for (theory_node* node = theory_first(set); node != NULL; node = theory_next(set, node)) { ++count; }
+
+    parallel_task* task = (parallel_task*)malloc(sizeof(parallel_task) + count * sizeof(tree_node*));
+    task->count = 0;
+
+    // The formulas are pushed back in reverse order, so the extra formulas come first (in the order first, second)
+    // and the theory keeps its order.
+    if (second != NULL) { task->formulas[task->count++] = second; }
+    if (first != NULL) { task->formulas[task->count++] = first; }
+    for (theory_node* node = theory_first(set); node != NULL; node = theory_next(set, node))
+    {
+        task->formulas[task->count++] = node->formula;
+    }
+
+    return task;
+}
+
+/*
+ * Pushes a task to the back of a deque.
+ */
+static void parallel_deque_push(parallel_deque* deque, parallel_task* task)
+{
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->back == deque->capacity)
+    {
+        if (deque->front > 0)
+        {
+            // Moves the tasks to the start of the array instead of growing it.
+            memmove(deque->tasks, deque->tasks + deque->front, (deque->back - deque->front) * sizeof(parallel_task*));
+            deque->back -= deque->front;
+            deque->front = 0;
+        }
+        else
+        {
+            deque->capacity = deque->capacity > 0 ? 2 * deque->capacity : 16;
+            deque->tasks = (parallel_task**)realloc(deque->tasks, deque->capacity * sizeof(parallel_task*));
+        }
+    }
+
+    deque->tasks[deque->back++] = task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/*
+ * Takes a task from the back (if back is set) or the front of a deque, or returns NULL if the deque is empty.
+ */
+static parallel_task* parallel_deque_take(parallel_deque* deque, bool back)
+{
+    parallel_task* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->front < deque->back)
+    {
+        task = back ? deque->tasks[--deque->back] : deque->tasks[deque->front++];
+        if (deque->front == deque->back) { deque->front = deque->back = 0; }
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/*
+ * Gets the number of tasks in a deque.
+ */
+static size_t parallel_deque_size(parallel_deque* deque)
+{
+    pthread_mutex_lock(&deque->lock);
+    size_t size = deque->back - deque->front;
+    pthread_mutex_unlock(&deque->lock);
+    return size;
+}
+
+/*
+ * Wakes the sleeping workers after a task is spawned, the last task is searched or the search stops. The lock is only
+ * taken when a worker may be sleeping.
+ */
+static void parallel_wake(parallel_search* search)
+{
+    if (__atomic_load_n(&search->idle, __ATOMIC_SEQ_CST) == 0) { return; }
+
+    pthread_mutex_lock(&search->lock);
+    pthread_cond_broadcast(&search->changed);
+    pthread_mutex_unlock(&search->lock);
+}
+
+/*
+ * Spawn hook of the depth-first search of a worker: turns the right branch of a beta expansion into a task of the
+ * worker's deque while the deque is short, so idle workers have branches to steal.
+ */
+static bool parallel_spawn(void* context, theory* set, tree_node* first, tree_node* second)
+{
+    parallel_worker* worker = (parallel_worker*)context;
+    if (parallel_deque_size(&worker->deque) >= spawn_limit) { return false; }
+
+    __atomic_add_fetch(&worker->search->pending, 1, __ATOMIC_SEQ_CST);
+    parallel_deque_push(&worker->deque, parallel_task_create(set, first, second));
+    __atomic_add_fetch(&worker->search->spawned, 1, __ATOMIC_SEQ_CST);
+    parallel_wake(worker->search);
+    return true;
+}
+
+/*
+ * Puts an idle worker to sleep until a task is spawned after it last looked for one (spawned was seen before the
+ * look), every task has been searched or the search stops. The idle count is raised before the spawn counter is
+ * checked, so a spawn either is seen here or sees the sleeper and wakes it.
+ */
+static void parallel_sleep(parallel_search* search, size_t seen)
+{
+    pthread_mutex_lock(&search->lock);
+    __atomic_add_fetch(&search->idle, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&search->spawned, __ATOMIC_SEQ_CST) == seen &&
+           __atomic_load_n(&search->pending, __ATOMIC_SEQ_CST) > 0 && !__atomic_load_n(&search->stop, __ATOMIC_SEQ_CST))
+    {
+        pthread_cond_wait(&search->changed, &search->lock);
+    }
+
+    __atomic_sub_fetch(&search->idle, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&search->lock);
+}
+
+/*
+ * Gets the next task of a worker: the newest task of its own deque, or else the oldest task of another worker.
+ */
+static parallel_task* parallel_next_task(parallel_worker* worker)
+{
+    parallel_task* task = parallel_deque_take(&worker->deque, true);
+    parallel_search* search = worker->search;
+
+    for (size_t i = 1; task == NULL && i < search->count; ++i)
+    {
+        task = parallel_deque_take(&search->workers[(worker->id + i) % search->count].deque, false);
+    }
+
+    return task;
+}
+
+/*
+ * Runs a worker until a worker finds an open branch, a worker runs out of budget or every task has been searched.
+ */
+static void* parallel_work(void* argument)
+{
+    parallel_worker* worker = (parallel_worker*)argument;
+    parallel_search* search = worker->search;
+
+    while (!__atomic_load_n(&search->stop, __ATOMIC_RELAXED))
+    {
+        size_t seen = __atomic_load_n(&search->spawned, __ATOMIC_SEQ_CST);
+        parallel_task* task = parallel_next_task(worker);
+        if (task == NULL)
+        {
+            // Tasks may still be spawned by the busy workers until no task is pending.
+            if (__atomic_load_n(&search->pending, __ATOMIC_SEQ_CST) == 0) { break; }
+            parallel_sleep(search, seen);
+            continue;
+        }
+
+        theory* set = theory_create(worker->proof);
+        for (size_t i = task->count; i-- > 0;)
+        {
+            theory_push(set, task->formulas[i]);
+        }
+
+        free(task);
+
+        prover_result result = tableau_depth_first(worker->proof, set, &worker->selection, &search->branching,
+                                                   parallel_spawn, worker, &search->stop, &worker->budget,
+                                                   &worker->stats);
+        if (result == result_true && !__atomic_exchange_n(&search->satisfiable, true, __ATOMIC_SEQ_CST) &&
+            search->valuation != NULL)
+        {
+            theory_valuation(set, search->valuation); // only the first worker to find an open branch reports it.
+        }
+
+        bool stopped = result == result_true || worker->budget.exhausted;
+        if (stopped)
+        {
+            if (worker->budget.exhausted) { __atomic_store_n(&search->exhausted, true, __ATOMIC_SEQ_CST); }
+            __atomic_store_n(&search->stop, true, __ATOMIC_SEQ_CST);
+        }
+
+        theory_free(set);
+        if (__atomic_sub_fetch(&search->pending, 1, __ATOMIC_SEQ_CST) == 0 || stopped) { parallel_wake(search); }
+    }
+
+    return NULL;
+}
+
+/*
+ * Searches the root task (with its formulas in the factory) with the number of workers of the options and sums their
+ * statistics (the peak bytes of the workers are added up as an upper bound). Each worker gets an even share of the
+ * expansion and byte limits and a copy of the selection policy, and they share the branching rule. Takes ownership of
+ * the root task.
+ * If the valuation is not NULL the propositions that are true on the open branch are set in it.
+ */
+static prover_result parallel_run(formula_factory* factory, parallel_task* root, const prover_options* options,
+                                  bool* valuation, prover_stats* stats)
+{
+    // The selection and the branching rule are prepared once for all workers, which do not create formulas.
+    parallel_search search;
+    selection selection;
+    arena* scratch = arena_create();
+    theory* set = theory_create(scratch);
+    for (size_t i = 0; i < root->count; ++i)
+    {
+        theory_push(set, root->formulas[i]);
+    }
+
+    branching_init(&search.branching, options->branching, factory, set);
+    selection_init(&selection, options->selection, options->seed, factory, set);
+    arena_free(scratch);
+
+    search.valuation = valuation;
+    search.count = (size_t)parallel_thread_count(options->threads);
+    search.workers = (parallel_worker*)calloc(search.count, sizeof(parallel_worker));
+    search.satisfiable = false;
+    search.exhausted = false;
+    search.stop = false;
+    search.pending = 1;
+    search.spawned = 0;
+    search.idle = 0;
+    pthread_mutex_init(&search.lock, NULL);
+    pthread_cond_init(&search.changed, NULL);
+
+    for (size_t i = 0; i < search.count; ++i)
+    {
+        parallel_worker* worker = &search.workers[i];
+        worker->search = &search;
+        worker->id = i;
+        worker->proof = arena_create();
+        budget_init(&worker->budget, &options->limits, (int)search.count);
+        selection_fork(&worker->selection, &selection, i);
+        pthread_mutex_init(&worker->deque.lock, NULL);
+    }
+
+    parallel_deque_push(&search.workers[0].deque, root);
+
+    // A worker whose thread cannot be created has an empty deque and is simply left out.
+    for (size_t i = 1; i < search.count; ++i)
+    {
+        search.workers[i].started = pthread_create(&search.workers[i].thread, NULL, parallel_work,
+                                                   &search.workers[i]) == 0;
+    }
+
+    parallel_work(&search.workers[0]);
+
+    // Every worker has to stop before any deque is destroyed, since the workers steal from each other.
+    for (size_t i = 1; i < search.count; ++i)
+    {
+        if (search.workers[i].started) { pthread_join(search.workers[i].thread, NULL); }
+    }
+
+    for (size_t i = 0; i < search.count; ++i)
+    {
+        parallel_worker* worker = &search.workers[i];
+
+        if (stats != NULL)
+        {
+            stats->expansions += worker->stats.expansions;
+            stats->branches += worker->stats.branches;
+            stats->peak_bytes += worker->proof->peak_bytes;
+            stats->total_bytes += worker->proof->total_bytes;
+        }
+
+        // Tasks are left in the deques when the search is cancelled.
+        parallel_task* task;
+        while ((task = parallel_deque_take(&worker->deque, true)) != NULL) { free(task); }
+        free(worker->deque.tasks);
+        pthread_mutex_destroy(&worker->deque.lock);
+        arena_free(worker->proof);
+    }
+
+    free(search.workers);
+    pthread_cond_destroy(&search.changed);
+    pthread_mutex_destroy(&search.lock);
+    selection_destroy(&selection);
+    branching_destroy(&search.branching);
+    return search.satisfiable ? result_true : (search.exhausted ? result_unknown : result_false);
+}
+
+/*
+ * Parallel tableau algorithm tests whether a propositional formula (or its negation if negated is set) is satisfiable
+ * with the number of workers (0 for one per online processor), limits, selection policy and branching rule of the
+ * options. Each worker searches its branches depth-first and turns the right branches of beta expansions into tasks
+ * that idle workers steal, and the first open branch (or the first worker out of budget) cancels every worker.
+ */
+prover_result parallel_tableau_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                         const prover_options* options, bool* valuation, prover_stats* stats)
+{
+    parallel_task* root = (parallel_task*)malloc(sizeof(parallel_task) + sizeof(tree_node*));
+    root->count = 1;
+    root->formulas[0] = nnf_formula(factory, formula, negated); // the workers do not create formulas.
+    return parallel_run(factory, root, options, valuation, stats);
+}
+
+/*
+ * Parallel tableau algorithm tests whether a theory (the conjunction of its formulas) is satisfiable with the number
+ * of workers, limits, selection policy and branching rule of the options. The theory is left unchanged.
+ */
+prover_result parallel_tableau_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                                bool* valuation, prover_stats* stats)
+{
+    arena* scratch = arena_create();
+    parallel_task* task = parallel_task_create(nnf_theory(factory, scratch, root), NULL, NULL);
+    arena_free(scratch);
+    return parallel_run(factory, task, options, valuation, stats);
+}
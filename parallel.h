@@ -0,0 +1,17 @@
+#ifndef THEOREMPROVER_PARALLEL_H
+#define THEOREMPROVER_PARALLEL_H
+
+#include <stdbool.h>
+#include "factory.h"
+#include "theory.h"
+#include "prover.h"
+
+int parallel_thread_count(int threads);
+
+prover_result parallel_tableau_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                         const prover_options* options, bool* valuation, prover_stats* stats);
+
+prover_result parallel_tableau_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                                bool* valuation, prover_stats* stats);
+
+#endif //THEOREMPROVER_PARALLEL_H
@@ -3,98 +3,120 @@
 #include <stdlib.h>
 
 /*
- * Helper function for parsing a binary formula.
+ * Parse frames record the enclosing formulas that are still waiting for a subformula:
+ * a negation waiting for its operand, a left parenthesis waiting for its left operand,
+ * or a binary connective (with its left operand) waiting for its right operand.
  */
-tree_node* parse_binary_formula(char* formula, int* offset, token* current_token)
+typedef enum frame_type
 {
-    tree_node* left_formula;
-    tree_node* right_formula;
-    token binary_token;
+    negation_frame,
+    left_operand_frame,
+    right_operand_frame
+} frame_type;
 
-    left_formula = parse_formula(formula, offset, current_token);
+typedef struct parse_frame
+{
+    frame_type type;
+    token token;
+    tree_node* left_formula;
+} parse_frame;
 
-    get_token(formula, offset, current_token);
-    binary_token = *current_token;
+/*
+ * Parses a propositional formula with an explicit stack of parse frames, so the nesting depth of the formula is only
+ * limited by the available memory. Each token is read once so parsing takes time linear in the length of the formula.
+ */
+tree_node* parse_formula(formula_factory* factory, char* formula, size_t* offset, token* current_token)
+{
+    parse_frame* frames = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    tree_node* node = NULL;
 
-    if (left_formula != NULL && binary_token.type == binary_connective)
+    while (true)
     {
-        right_formula = parse_formula(formula, offset, current_token);
-        if (right_formula != NULL)
+        // Read prefixes (negations and left parentheses) until a proposition is found.
+        get_token(formula, offset, current_token);
+
+        if (current_token->type == negation || current_token->type == left_parenthesis)
         {
-            get_token(formula, offset, current_token);
-            if (current_token->type == right_parenthesis)
+            if (size == capacity)
             {
-                return binary_formula(binary_token, left_formula, right_formula);
+                capacity = capacity == 0 ? 64 : 2 * capacity;
+                frames = (parse_frame*)realloc(frames, capacity * sizeof(parse_frame));
             }
 
-            if (current_token->type == end)
-            {
-                --(*offset);
-            }
+            frames[size].type = current_token->type == negation ? negation_frame : left_operand_frame;
+            frames[size].token = *current_token;
+            frames[size].left_formula = NULL;
+            ++size;
+            continue;
         }
-    }
 
-    return NULL;
-}
+        if (current_token->type != proposition) { goto error; }
 
-/*
- * Helper function for parsing a negated formula.
- */
-tree_node* parse_negated_formula(char* formula, int* offset, token* current_token)
-{
-    token negation = *current_token;
-    tree_node* left_formula = parse_formula(formula, offset, current_token);
+        node = proposition_formula(factory, *current_token);
 
-    if (left_formula != NULL)
-    {
-        return negated_formula(negation, left_formula);
-    }
+        // Complete the enclosing formulas until one of them needs another operand.
+        while (size > 0)
+        {
+            parse_frame* frame = &frames[size - 1];
 
-    return NULL;
-}
+            if (frame->type == negation_frame)
+            {
+                node = negated_formula(factory, frame->token, node);
+                --size;
+            }
+            else if (frame->type == left_operand_frame)
+            {
+                get_token(formula, offset, current_token);
+                if (current_token->type != binary_connective) { goto error; }
+
+                frame->type = right_operand_frame;
+                frame->token = *current_token;
+                frame->left_formula = node;
+                node = NULL;
+                break;
+            }
+            else
+            {
+                get_token(formula, offset, current_token);
+                if (current_token->type != right_parenthesis) { goto error; }
 
-/*
- * Helper function for parsing a propositional formula.
- */
-tree_node* parse_formula(char* formula, int* offset, token* current_token)
-{
-    get_token(formula, offset, current_token);
+                node = binary_formula(factory, frame->token, frame->left_formula, node);
+                --size;
+            }
+        }
 
-    switch (current_token->type)
-    {
-        case proposition:
-            return proposition_formula(*current_token);
-        case negation:
-            return parse_negated_formula(formula, offset, current_token);
-        case left_parenthesis:
-            return parse_binary_formula(formula, offset, current_token);
-        case end:
-            --(*offset);
-            return NULL;
-        default:
-            return NULL;
+        if (size == 0)
+        {
+            free(frames);
+            return node;
+        }
     }
+
+error:
+    // The partially parsed subformulas are owned by the factory.
+    free(frames);
+    return NULL;
 }
 
 /*
- * Parses the propositional formula as a binary tree.
+ * Parses the propositional formula as a binary tree whose nodes are owned by the factory.
  */
-tree_node* parse(char* formula)
+tree_node* parse(formula_factory* factory, char* formula)
 {
-    int offset = 0;
-    token* current_token = token_alloc();
+    size_t offset = 0;
+    token current_token;
 
-    tree_node* node = parse_formula(formula, &offset, current_token);
+    tree_node* node = parse_formula(factory, formula, &offset, &current_token);
 
     if (node == NULL) { return NULL; }
 
-    get_token(formula, &offset, current_token);
-    if (!is_end(current_token->symbol))
+    get_token(formula, &offset, &current_token);
+    if (current_token.type != end || !is_end(current_token.symbol))
     {
         return NULL;
     }
 
-    token_free(current_token);
-
     return node;
-}
\ No newline at end of file
+}
@@ -1,14 +1,11 @@
 #ifndef THEOREMPROVER_PARSER_H
 #define THEOREMPROVER_PARSER_H
 
+#include <stddef.h>
 #include "tree.h"
 
-tree_node* parse_binary_formula(char* formula, int* offset, token* current_token);
+tree_node* parse_formula(formula_factory* factory, char* formula, size_t* offset, token* current_token);
 
-tree_node* parse_negated_formula(char* formula, int* offset, token* current_token);
-
-tree_node* parse_formula(char* formula, int* offset, token* current_token);
-
-tree_node* parse(char* formula);
+tree_node* parse(formula_factory* factory, char* formula);
 
 #endif //THEOREMPROVER_PARSER_H
@@ -0,0 +1,275 @@
+#include "portfolio.h"
+#include "flat.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct portfolio_race portfolio_race;
+
+/*
+ * Portfolio racer runs one engine of the portfolio on its own thread, on a copy of the query in a factory of its own
+ * (the engines create formulas, and a factory is not shared between threads). The copy is built from the flat
+ * encoding of the query, which holds no pointers into the factory of the caller.
+ */
+typedef struct portfolio_racer
+{
+    portfolio_race* race;
+    pthread_t thread;
+    bool started;
+    prover_options options; // options of the query with the engine of the racer and the cancel flag of the race.
+    formula_factory* factory;
+    tree_node* formula;     // copy of the formula, or NULL for a theory.
+    theory* theory;         // copy of the theory, or NULL for a formula.
+    bool negated;
+    bool model;             // the query asks for a model.
+    prover_model found;     // model of a satisfiable query.
+    prover_result result;
+    prover_stats stats;
+} portfolio_racer;
+
+/*
+ * Portfolio race is shared by the racers of one query. The first racer that decides the query becomes the winner and
+ * sets the cancel flag, which stops the others at their next budget check.
+ */
+struct portfolio_race
+{
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    portfolio_racer* racers;
+    int count;
+    int running;            // racers that have not finished yet.
+    int winner;             // index of the winner (-1 while there is none).
+    bool cancel;
+};
+
+/*
+ * Parses a comma separated list of engine names (for example "dfs,cdcl,bdd") into the engines of a portfolio,
+ * returning false if a name is not an engine, if it names the portfolio itself, or if the list is empty or too long.
+ */
+bool portfolio_parse(const char* names, prover_engine* engines, int* count)
+{
+    size_t length = strlen(names);
+    char* copy = (char*)malloc(length + 1);
+    memcpy(copy, names, length + 1);
+
+    bool parsed = true;
+    char* name = copy;
+    *count = 0;
+    while (parsed)
+    {
+        char* end = strchr(name, ',');
+        if (end != NULL) { *end = '\0'; }
+
+        prover_engine engine;
+        parsed = *count < PROVER_PORTFOLIO_MAX && prover_engine_parse(name, &engine) && engine < engine_portfolio;
+        if (parsed) { engines[(*count)++] = engine; }
+
+        if (end == NULL) { break; }
+        name = end + 1;
+    }
+
+    free(copy);
+    return parsed;
+}
+
+/*
+ * Runs the engine of a racer and reports its result to the race: a decided result wins if no racer has won yet, and
+ * cancels the others.
+ */
+static void* portfolio_run(void* argument)
+{
+    portfolio_racer* racer = (portfolio_racer*)argument;
+    const prover_options* options = &racer->options;
+    formula_factory* factory = racer->factory;
+    prover_stats* stats = &racer->stats;
+    prover_result result;
+
+    if (racer->theory != NULL)
+    {
+        result = racer->model ? theory_model(factory, racer->theory, options, &racer->found, stats)
+                              : theory_satisfiable(factory, racer->theory, options, stats);
+    }
+    else if (racer->model)
+    {
+        result = racer->negated ? falsifying_model(factory, racer->formula, options, &racer->found, stats)
+                                : satisfying_model(factory, racer->formula, options, &racer->found, stats);
+    }
+    else if (racer->negated)
+    {
+        // the negation is satisfiable iff the formula is not valid.
+        result = is_valid(factory, racer->formula, options, stats);
+        if (result != result_unknown) { result = result == result_true ? result_false : result_true; }
+    }
+    else
+    {
+        result = is_satisfiable(factory, racer->formula, options, stats);
+    }
+
+    portfolio_race* race = racer->race;
+    pthread_mutex_lock(&race->lock);
+    racer->result = result;
+    if (result != result_unknown && race->winner < 0)
+    {
+        race->winner = (int)(racer - race->racers);
+        __atomic_store_n(&race->cancel, true, __ATOMIC_RELAXED);
+    }
+
+    --race->running;
+    pthread_cond_signal(&race->finished);
+    pthread_mutex_unlock(&race->lock);
+    return NULL;
+}
+
+/*
+ * Races the engines of the portfolio of the options on the racers (whose queries are set) and waits for the first
+ * verdict, then cancels and joins the other racers. Stores the model of the winner in the valuation if it is not NULL
+ * and the query is satisfiable, and the statistics of the winner (with its engine) in the statistics. The query is
+ * unknown if every racer stops without a verdict.
+ */
+static prover_result portfolio_run_race(portfolio_race* race, bool* valuation, prover_stats* stats)
+{
+    pthread_mutex_init(&race->lock, NULL);
+    pthread_cond_init(&race->finished, NULL);
+    race->running = race->count;
+    race->winner = -1;
+    race->cancel = false;
+
+    for (int i = 0; i < race->count; ++i)
+    {
+        portfolio_racer* racer = &race->racers[i];
+        racer->race = race;
+        racer->model = valuation != NULL;
+        racer->result = result_unknown;
+        racer->options.limits.cancel = &race->cancel;
+        racer->started = pthread_create(&racer->thread, NULL, portfolio_run, racer) == 0;
+        if (!racer->started)
+        {
+            // A racer whose thread cannot be created is left out of the race.
+            pthread_mutex_lock(&race->lock);
+            --race->running;
+            pthread_mutex_unlock(&race->lock);
+        }
+    }
+
+    pthread_mutex_lock(&race->lock);
+    while (race->winner < 0 && race->running > 0) { pthread_cond_wait(&race->finished, &race->lock); }
+    __atomic_store_n(&race->cancel, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&race->lock);
+
+    // The losers stop at their next budget check, and every racer has to stop before its factory is freed.
+    for (int i = 0; i < race->count; ++i)
+    {
+        if (race->racers[i].started) { pthread_join(race->racers[i].thread, NULL); }
+    }
+
+    prover_result result = result_unknown;
+    if (race->winner >= 0)
+    {
+        portfolio_racer* winner = &race->racers[race->winner];
+        result = winner->result;
+        if (stats != NULL) { *stats = winner->stats; }
+        if (valuation != NULL && result == result_true)
+        {
+            for (size_t i = 0; i < winner->found.size; ++i)
+            {
+                valuation[winner->found.propositions[i]] = winner->found.values[i];
+            }
+        }
+    }
+
+    for (int i = 0; i < race->count; ++i)
+    {
+        portfolio_racer* racer = &race->racers[i];
+        if (racer->model && racer->started) { prover_model_free(&racer->found); }
+        factory_free(racer->factory);
+    }
+
+    pthread_cond_destroy(&race->finished);
+    pthread_mutex_destroy(&race->lock);
+    free(race->racers);
+    return result;
+}
+
+/*
+ * Creates the racers of the portfolio of the options, each with the options of the query for its engine. The
+ * racers do not use the result cache, which was applied to the query as a whole.
+ */
+static void portfolio_create(portfolio_race* race, const prover_options* options)
+{
+    race->count = options->portfolio_size;
+    race->racers = (portfolio_racer*)calloc((size_t)race->count + 1, sizeof(portfolio_racer));
+    for (int i = 0; i < race->count; ++i)
+    {
+        portfolio_racer* racer = &race->racers[i];
+        racer->options = *options;
+        racer->options.engine = options->portfolio[i];
+        racer->options.cache = NULL;
+        racer->options.portfolio_size = 0;
+        racer->factory = factory_create();
+    }
+}
+
+/*
+ * Portfolio algorithm tests whether a formula (or its negation if negated is set) is satisfiable by racing the
+ * engines of the portfolio of the options on threads, each on its own copy of the formula, and takes the first
+ * verdict. The formula is flattened once and the copies are built from the flat formula before the race starts, since
+ * the factory of the query is not shared.
+ */
+prover_result portfolio_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                  const prover_options* options, bool* valuation, prover_stats* stats)
+{
+    (void)factory;
+    flat_formula flat;
+    flat_init(&flat);
+    flat_from_tree(&flat, formula);
+
+    portfolio_race race;
+    portfolio_create(&race, options);
+    for (int i = 0; i < race.count; ++i)
+    {
+        race.racers[i].formula = flat_to_tree(race.racers[i].factory, &flat);
+        race.racers[i].negated = negated;
+    }
+
+    flat_destroy(&flat);
+    return portfolio_run_race(&race, valuation, stats);
+}
+
+/*
+ * Portfolio theory algorithm tests whether a theory (the conjunction of its formulas) is satisfiable by racing the
+ * engines of the portfolio of the options on copies of the theory.
+ */
+prover_result portfolio_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                         bool* valuation, prover_stats* stats)
+{
+    (void)factory;
+    size_t count = 0;
+    for (theory_node* node = theory_first(root); node != NULL; node = theory_next(root, node)) { ++count; }
+
+    // The formulas of the theory follow each other in one flat formula.
+    flat_formula flat;
+    flat_init(&flat);
+    uint32_t* roots = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+    tree_node** copies = (tree_node**)malloc((count + 1) * sizeof(tree_node*));
+    count = 0;
+    for (theory_node* node = theory_first(root); node != NULL; node = theory_next(root, node))
+    {
+        roots[count++] = flat_append_tree(&flat, node->formula);
+    }
+
+    portfolio_race race;
+    portfolio_create(&race, options);
+    for (int i = 0; i < race.count; ++i)
+    {
+        portfolio_racer* racer = &race.racers[i];
+        flat_to_trees(racer->factory, &flat, roots, count, copies);
+        racer->theory = theory_create(racer->factory->arena);
+        for (size_t j = 0; j < count; ++j) { theory_push(racer->theory, copies[j]); }
+    }
+
+    free(copies);
+    free(roots);
+    flat_destroy(&flat);
+    return portfolio_run_race(&race, valuation, stats);
+}
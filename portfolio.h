@@ -0,0 +1,17 @@
+#ifndef THEOREMPROVER_PORTFOLIO_H
+#define THEOREMPROVER_PORTFOLIO_H
+
+#include <stdbool.h>
+#include "factory.h"
+#include "theory.h"
+#include "prover.h"
+
+bool portfolio_parse(const char* names, prover_engine* engines, int* count);
+
+prover_result portfolio_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                  const prover_options* options, bool* valuation, prover_stats* stats);
+
+prover_result portfolio_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                         bool* valuation, prover_stats* stats);
+
+#endif //THEOREMPROVER_PORTFOLIO_H
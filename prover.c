@@ -0,0 +1,528 @@
+#include "prover.h"
+#include "tableaux.h"
+#include "tseitin.h"
+#include "parallel.h"
+#include "cache.h"
+#include "truth_table.h"
+#include "portfolio.h"
+#include "symbol_table.h"
+#include "tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const int default_table_variables = 16; // largest formulas (in propositions) decided by their truth table.
+
+// engines raced by default by the portfolio engine.
+static const prover_engine default_portfolio[] = { engine_tableau, engine_dfs, engine_cdcl, engine_bdd };
+
+static const char* const engine_names[] = { "tableau", "cdcl", "dfs", "parallel", "truth-table", "bdd", "portfolio",
+                                              "automatic" };
+
+/*
+ * Initializes the options with the defaults (the automatic engine, which is the truth table engine for formulas with at
+ * most 16 propositions and the tableau engine otherwise, one thread per processor for the parallel engine, no limits,
+ * alpha formulas first with the most recent beta formula, syntactic branching, no result cache, the BDD variables in
+ * order of appearance with a manager per query, and a portfolio of the tableau, dfs, cdcl and bdd engines).
+ */
+void prover_options_init(prover_options* options)
+{
+    options->engine = engine_automatic;
+    options->threads = 0;
+    memset(&options->limits, 0, sizeof(options->limits));
+    options->selection = select_alpha_first;
+    options->seed = 0;
+    options->branching = branch_syntactic;
+    options->cache = NULL;
+    options->table_variables = default_table_variables;
+    options->ordering = bdd_order_appearance;
+    options->bdd = NULL;
+    options->portfolio_size = (int)(sizeof(default_portfolio) / sizeof(default_portfolio[0]));
+    memcpy(options->portfolio, default_portfolio, sizeof(default_portfolio));
+}
+
+/*
+ * Parses an engine name, returning false if the name is not an engine.
+ */
+bool prover_engine_parse(const char* name, prover_engine* engine)
+{
+    for (size_t i = 0; i < sizeof(engine_names) / sizeof(engine_names[0]); ++i)
+    {
+        if (strcmp(name, engine_names[i]) == 0)
+        {
+            *engine = (prover_engine)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Gets the name of an engine.
+ */
+const char* prover_engine_name(prover_engine engine)
+{
+    return engine_names[engine];
+}
+
+/*
+ * Solves the clauses of an encoder's solver within the limits (none if NULL), copies its statistics and, if the
+ * clauses are satisfiable and the valuation is not NULL, stores the values of the encoded propositions in the
+ * valuation. Frees the encoder and the solver.
+ */
+static prover_result cdcl_prove(tseitin_encoder* encoder, const prover_limits* limits, bool* valuation,
+                                prover_stats* stats)
+{
+    cdcl_solver* solver = encoder->solver;
+    budget budget;
+    budget_init(&budget, limits, 1);
+    solver->budget = &budget;
+
+    bool satisfiable = cdcl_solve(solver);
+    prover_result result = satisfiable ? result_true : (solver->stopped ? result_unknown : result_false);
+
+    if (satisfiable && valuation != NULL)
+    {
+        for (size_t id = 0; id < encoder->proposition_capacity; ++id)
+        {
+            int variable = encoder->proposition_vars[id];
+            if (variable >= 0) { valuation[id] = cdcl_model_value(solver, variable); }
+        }
+    }
+
+    if (stats != NULL)
+    {
+        stats->decisions = solver->stats.decisions;
+        stats->conflicts = solver->stats.conflicts;
+        stats->peak_bytes = solver->stats.peak_bytes;
+        stats->total_bytes = solver->stats.total_bytes;
+    }
+
+    tseitin_destroy(encoder);
+    cdcl_free(solver);
+    return result;
+}
+
+/*
+ * Tests whether a formula (or its negation if negated is set) is satisfiable with the CDCL engine.
+ */
+static prover_result cdcl_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                    const prover_limits* limits, bool* valuation, prover_stats* stats)
+{
+    tseitin_encoder encoder;
+    tseitin_init(&encoder, factory, cdcl_create());
+    tseitin_assert(&encoder, formula, negated);
+    return cdcl_prove(&encoder, limits, valuation, stats);
+}
+
+/*
+ * Tests whether a theory is satisfiable with the CDCL engine.
+ */
+static prover_result cdcl_theory_algorithm(formula_factory* factory, theory* theory, const prover_limits* limits,
+                                           bool* valuation, prover_stats* stats)
+{
+    tseitin_encoder encoder;
+    tseitin_init(&encoder, factory, cdcl_create());
+    tseitin_assert_theory(&encoder, theory);
+    return cdcl_prove(&encoder, limits, valuation, stats);
+}
+
+/*
+ * Tests whether a formula (or its negation if negated is set), or else a theory, is satisfiable by building its BDD in
+ * the manager of the options (or in a manager for this query), storing the values of a model in the valuation if it
+ * is not NULL. The expansion limit bounds the misses of the computed cache.
+ */
+static prover_result bdd_algorithm(formula_factory* factory, tree_node* formula, theory* theory, bool negated,
+                                   const prover_options* options, bool* valuation, prover_stats* stats)
+{
+    bdd_manager* manager = options->bdd != NULL ? options->bdd : bdd_manager_create(options->ordering);
+    budget budget;
+    budget_init(&budget, &options->limits, 1);
+    bdd_begin_query(manager, &budget);
+
+    bdd root = formula != NULL ? bdd_from_formula(manager, factory, formula)
+                               : bdd_from_theory(manager, factory, theory);
+    if (negated)
+    {
+        bdd complement = bdd_ref(manager, bdd_not(manager, root));
+        bdd_deref(manager, root);
+        root = complement;
+    }
+
+    prover_result result = manager->stopped ? result_unknown : (bdd_satisfiable(root) ? result_true : result_false);
+    if (result == result_true && valuation != NULL) { bdd_model(manager, root, valuation); }
+
+    if (stats != NULL)
+    {
+        stats->peak_bytes = manager->bytes;
+        stats->total_bytes = manager->bytes;
+    }
+
+    bdd_deref(manager, root);
+    bdd_end_query(manager);
+    if (options->bdd == NULL) { bdd_manager_free(manager); }
+    return result;
+}
+
+/*
+ * Runs the engine of the options on a formula (or its negation if negated is set). Without a chosen engine, a formula
+ * with few enough propositions for the truth table threshold of the options is decided by its truth table, and the
+ * others by the tableau.
+ */
+static prover_result prover_solve(formula_factory* factory, tree_node* formula, bool negated,
+                                  const prover_options* options, bool* valuation, prover_stats* stats)
+{
+    prover_engine engine = options->engine;
+    if (engine == engine_truth_table || (engine == engine_automatic && options->table_variables > 0))
+    {
+        truth_table table;
+        truth_table_compile(&table, factory, formula, negated);
+        if (engine == engine_truth_table || table.variables <= (size_t)options->table_variables)
+        {
+            if (stats != NULL) { stats->engine = engine_truth_table; }
+            return truth_table_prove(&table, &options->limits, valuation, NULL, stats);
+        }
+
+        truth_table_destroy(&table);
+    }
+
+    if (engine == engine_automatic) { engine = engine_tableau; }
+    if (stats != NULL) { stats->engine = engine; }
+    if (engine == engine_cdcl)
+    {
+        return cdcl_algorithm(factory, formula, negated, &options->limits, valuation, stats);
+    }
+    else if (engine == engine_parallel)
+    {
+        return parallel_tableau_algorithm(factory, formula, negated, options, valuation, stats);
+    }
+    else if (engine == engine_bdd)
+    {
+        return bdd_algorithm(factory, formula, NULL, negated, options, valuation, stats);
+    }
+    else if (engine == engine_portfolio)
+    {
+        return portfolio_algorithm(factory, formula, negated, options, valuation, stats);
+    }
+
+    return tableau_algorithm(factory, formula, negated, options, valuation, stats);
+}
+
+/*
+ * Tests whether a formula (or its negation if negated is set) is satisfiable with the engine of the options, or
+ * reads the verdict from the result cache of the options (if any), where it is stored after a miss. A query answered
+ * by the cache does no work, so its statistics are zero.
+ * If the valuation is not NULL (an array indexed by proposition id with every value false) the values of a satisfying
+ * valuation are stored in it.
+ */
+static prover_result prover_formula(formula_factory* factory, tree_node* formula, bool negated,
+                                    const prover_options* options, bool* valuation, prover_stats* stats)
+{
+    if (stats != NULL) { memset(stats, 0, sizeof(*stats)); }
+
+    prover_options defaults;
+    if (options == NULL)
+    {
+        prover_options_init(&defaults);
+        options = &defaults;
+    }
+
+    if (stats != NULL) { stats->engine = options->engine; }
+    if (options->cache == NULL) { return prover_solve(factory, formula, negated, options, valuation, stats); }
+
+    cache_key key;
+    cache_key_create(&key, factory, formula, negated);
+    prover_result result = result_cache_lookup(options->cache, &key, valuation);
+    if (result == result_unknown)
+    {
+        result = prover_solve(factory, formula, negated, options, valuation, stats);
+        result_cache_store(options->cache, &key, result, valuation);
+    }
+
+    cache_key_free(&key);
+    return result;
+}
+
+/*
+ * Tests whether a theory (the conjunction of its formulas) is satisfiable with the engine of the options, storing the
+ * values of a satisfying valuation in the valuation if it is not NULL.
+ */
+static prover_result prover_theory(formula_factory* factory, theory* theory, const prover_options* options,
+                                   bool* valuation, prover_stats* stats)
+{
+    if (stats != NULL) { memset(stats, 0, sizeof(*stats)); }
+
+    prover_options defaults;
+    if (options == NULL)
+    {
+        prover_options_init(&defaults);
+        options = &defaults;
+    }
+
+    prover_engine engine = options->engine;
+    const prover_limits* limits = &options->limits;
+    if (engine == engine_truth_table || (engine == engine_automatic && options->table_variables > 0))
+    {
+        truth_table table;
+        truth_table_compile_theory(&table, factory, theory);
+        if (engine == engine_truth_table || table.variables <= (size_t)options->table_variables)
+        {
+            if (stats != NULL) { stats->engine = engine_truth_table; }
+            return truth_table_prove(&table, limits, valuation, NULL, stats);
+        }
+
+        truth_table_destroy(&table);
+    }
+
+    if (engine == engine_automatic) { engine = engine_tableau; }
+    if (stats != NULL) { stats->engine = engine; }
+    if (engine == engine_cdcl)
+    {
+        return cdcl_theory_algorithm(factory, theory, limits, valuation, stats);
+    }
+    else if (engine == engine_parallel)
+    {
+        return parallel_tableau_theory_algorithm(factory, theory, options, valuation, stats);
+    }
+    else if (engine == engine_bdd)
+    {
+        return bdd_algorithm(factory, NULL, theory, false, options, valuation, stats);
+    }
+    else if (engine == engine_portfolio)
+    {
+        return portfolio_theory_algorithm(factory, theory, options, valuation, stats);
+    }
+
+    return tableau_theory_algorithm(factory, theory, options, valuation, stats);
+}
+
+/*
+ * Tests whether a formula is satisfiable (true under at least one valuation).
+ */
+prover_result is_satisfiable(formula_factory* factory, tree_node* formula, const prover_options* options,
+                             prover_stats* stats)
+{
+    return prover_formula(factory, formula, false, options, NULL, stats);
+}
+
+/*
+ * Negates a result, leaving an unknown result unknown.
+ */
+static prover_result prover_negate(prover_result result)
+{
+    return result == result_unknown ? result_unknown : (result == result_true ? result_false : result_true);
+}
+
+/*
+ * Tests whether a formula is valid (true under all possible valuations).
+ * The negation is only taken during the conversion into negation normal form, so no negated root is created.
+ */
+prover_result is_valid(formula_factory* factory, tree_node* formula, const prover_options* options,
+                       prover_stats* stats)
+{
+    return prover_negate(prover_formula(factory, formula, true, options, NULL, stats)); // ϕ is valid ⟺ -ϕ is unsat.
+}
+
+/*
+ * Tests whether a theory (the conjunction of its formulas) is satisfiable. The theory is left unchanged.
+ */
+prover_result theory_satisfiable(formula_factory* factory, theory* theory, const prover_options* options,
+                                 prover_stats* stats)
+{
+    return prover_theory(factory, theory, options, NULL, stats);
+}
+
+/*
+ * Counts the models of a formula (the valuations of its propositions that satisfy it) with one sweep of its truth
+ * table, whatever the engine of the options, and returns whether it is satisfiable. The count is unknown for a formula
+ * with more than 62 propositions or when a limit stops the sweep.
+ */
+prover_result count_models(formula_factory* factory, tree_node* formula, const prover_options* options,
+                           uint64_t* models, prover_stats* stats)
+{
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+        stats->engine = engine_truth_table; // models are counted on the truth table whatever the engine.
+    }
+
+    truth_table table;
+    truth_table_compile(&table, factory, formula, false);
+    *models = 0;
+    return truth_table_prove(&table, options != NULL ? &options->limits : NULL, NULL, models, stats);
+}
+
+/*
+ * Tests whether two formulas are equivalent (true under the same valuations) by comparing their BDDs in the manager of
+ * the options (or in a manager for this query), whatever the engine of the options. Formulas whose BDDs are already in
+ * a shared manager are compared without any work.
+ */
+prover_result are_equivalent(formula_factory* factory, tree_node* first, tree_node* second,
+                             const prover_options* options, prover_stats* stats)
+{
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+        stats->engine = engine_bdd; // equivalence is decided on the BDDs whatever the engine.
+    }
+
+    prover_options defaults;
+    if (options == NULL)
+    {
+        prover_options_init(&defaults);
+        options = &defaults;
+    }
+
+    bdd_manager* manager = options->bdd != NULL ? options->bdd : bdd_manager_create(options->ordering);
+    budget budget;
+    budget_init(&budget, &options->limits, 1);
+    bdd_begin_query(manager, &budget);
+
+    bdd left = bdd_from_formula(manager, factory, first);
+    bdd right = bdd_from_formula(manager, factory, second);
+    prover_result result = manager->stopped ? result_unknown
+                                            : (bdd_equivalent(left, right) ? result_true : result_false);
+
+    if (stats != NULL)
+    {
+        stats->peak_bytes = manager->bytes;
+        stats->total_bytes = manager->bytes;
+    }
+
+    bdd_deref(manager, left);
+    bdd_deref(manager, right);
+    bdd_end_query(manager);
+    if (options->bdd == NULL) { bdd_manager_free(manager); }
+    return result;
+}
+
+/*
+ * Compares proposition ids for sorting.
+ */
+static int prover_compare_ids(const void* a, const void* b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Creates a valuation with every interned proposition false.
+ */
+static bool* prover_valuation_create()
+{
+    return (bool*)calloc((size_t)symbol_count() + 1, sizeof(bool));
+}
+
+/*
+ * Creates a model with the values in a valuation (indexed by proposition id) of the propositions of the factory, in
+ * increasing order of id.
+ */
+void prover_model_create(prover_model* model, formula_factory* factory, const bool* valuation)
+{
+    model->size = 0;
+    for (size_t i = 0; i <= factory->mask; ++i)
+    {
+        tree_node* node = factory->slots[i].node;
+        if (node != NULL && node->token.type == proposition) { ++model->size; }
+    }
+
+    model->propositions = (int*)malloc((model->size + 1) * sizeof(int));
+    model->values = (bool*)malloc((model->size + 1) * sizeof(bool));
+    model->size = 0;
+    for (size_t i = 0; i <= factory->mask; ++i)
+    {
+        tree_node* node = factory->slots[i].node;
+        if (node != NULL && node->token.type == proposition) { model->propositions[model->size++] = node->token.id; }
+    }
+
+    qsort(model->propositions, model->size, sizeof(int), prover_compare_ids);
+    for (size_t i = 0; i < model->size; ++i)
+    {
+        model->values[i] = valuation[model->propositions[i]];
+    }
+}
+
+/*
+ * Fills the model from the valuation if the query was satisfiable (or leaves it empty) and frees the valuation.
+ */
+static prover_result prover_model_fill(prover_model* model, formula_factory* factory, bool* valuation,
+                                       prover_result satisfiable)
+{
+    if (satisfiable == result_true)
+    {
+        prover_model_create(model, factory, valuation);
+    }
+    else
+    {
+        model->size = 0;
+        model->propositions = NULL;
+        model->values = NULL;
+    }
+
+    free(valuation);
+    return satisfiable;
+}
+
+/*
+ * Tests whether a formula is satisfiable and, if it is, fills the model with a satisfying valuation of its
+ * propositions, read off the open branch (or the solver assignment) that decided the query.
+ */
+prover_result satisfying_model(formula_factory* factory, tree_node* formula, const prover_options* options,
+                              prover_model* model, prover_stats* stats)
+{
+    bool* valuation = prover_valuation_create();
+    prover_result satisfiable = prover_formula(factory, formula, false, options, valuation, stats);
+    return prover_model_fill(model, factory, valuation, satisfiable);
+}
+
+/*
+ * Tests whether a formula is not valid and, if it is not, fills the model with a valuation of its propositions that
+ * falsifies it (a counterexample).
+ */
+prover_result falsifying_model(formula_factory* factory, tree_node* formula, const prover_options* options,
+                              prover_model* model, prover_stats* stats)
+{
+    bool* valuation = prover_valuation_create();
+    prover_result falsifiable = prover_formula(factory, formula, true, options, valuation, stats);
+    return prover_model_fill(model, factory, valuation, falsifiable);
+}
+
+/*
+ * Tests whether a theory is satisfiable and, if it is, fills the model with a satisfying valuation of the
+ * propositions of the factory. The theory is left unchanged.
+ */
+prover_result theory_model(formula_factory* factory, theory* theory, const prover_options* options, prover_model* model,
+                           prover_stats* stats)
+{
+    bool* valuation = prover_valuation_create();
+    prover_result satisfiable = prover_theory(factory, theory, options, valuation, stats);
+    return prover_model_fill(model, factory, valuation, satisfiable);
+}
+
+/*
+ * Writes a model as its literals separated by spaces: the name of each true proposition and the negation of each false
+ * one (for example "A -B C").
+ */
+void prover_model_print(const prover_model* model, FILE* output)
+{
+    for (size_t i = 0; i < model->size; ++i)
+    {
+        int id = model->propositions[i];
+        fprintf(output, "%s%s%.*s", i > 0 ? " " : "", model->values[i] ? "" : "-", (int)symbol_length(id),
+                symbol_name(id));
+    }
+}
+
+/*
+ * Frees the arrays of a model.
+ */
+void prover_model_free(prover_model* model)
+{
+    free(model->propositions);
+    free(model->values);
+    model->propositions = NULL;
+    model->values = NULL;
+    model->size = 0;
+}
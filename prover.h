@@ -0,0 +1,126 @@
+#ifndef THEOREMPROVER_PROVER_H
+#define THEOREMPROVER_PROVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "factory.h"
+#include "theory.h"
+#include "budget.h"
+#include "selection.h"
+#include "branching.h"
+#include "bdd.h"
+
+/*
+ * Prover engine selects the decision procedure behind is_satisfiable and is_valid.
+ */
+typedef enum prover_engine
+{
+    engine_tableau, // breadth-first tableau on the formula in negation normal form.
+    engine_cdcl,    // conflict-driven clause learning on the Tseitin encoding of the formula.
+    engine_dfs,     // depth-first tableau on a single theory with an undo trail.
+    engine_parallel,    // depth-first tableau on several threads that steal branches from each other.
+    engine_truth_table, // bit-parallel evaluation of the formula under every valuation of its propositions.
+    engine_bdd,         // reduced ordered binary decision diagram of the formula.
+    engine_portfolio,   // the engines of the portfolio raced on threads, taking the first verdict.
+    engine_automatic    // no engine chosen: the truth table up to the threshold of the options, the tableau above it.
+} prover_engine;
+
+#define PROVER_PORTFOLIO_MAX 8 // largest number of engines in a portfolio.
+
+/*
+ * Prover result is the three-valued answer to a query: it holds (satisfiable, or valid), it does not hold, or a
+ * resource limit stopped the search before the query was decided.
+ */
+typedef enum prover_result
+{
+    result_false,
+    result_true,
+    result_unknown
+} prover_result;
+
+typedef struct result_cache result_cache;
+
+/*
+ * Prover options configure a query (NULL options select the defaults).
+ */
+typedef struct prover_options
+{
+    prover_engine engine;
+    int threads;        // number of threads of the parallel engine (0 for one per online processor).
+    prover_limits limits;
+    selection_kind selection; // selection policy of the tableau engines.
+    uint64_t seed;      // seed of the random selection policy.
+    branching_kind branching; // beta rule of the tableau engines.
+    result_cache* cache;      // verdicts shared by the queries (NULL for none).
+    int table_variables;      // automatic engine: formulas with at most this many propositions use the truth table.
+    bdd_ordering ordering;    // variable ordering heuristic of the bdd engine.
+    bdd_manager* bdd;         // BDDs shared by the queries of the bdd engine (NULL for a manager per query).
+    prover_engine portfolio[PROVER_PORTFOLIO_MAX]; // engines raced by the portfolio engine.
+    int portfolio_size;
+} prover_options;
+
+/*
+ * Prover statistics describe the work and memory used by one query (up to the limit that stopped it, if any).
+ * Fields that do not apply to the engine are zero, and a portfolio reports the statistics of the engine that won.
+ */
+typedef struct prover_stats
+{
+    long expansions;    // number of alpha and beta rule applications (tableau).
+    long branches;      // number of expansions that split the branch in two (tableau).
+    long decisions;     // number of decisions (cdcl).
+    long conflicts;     // number of conflicts (cdcl).
+    size_t peak_bytes;  // peak bytes in use by theories and tableau nodes, or by clauses.
+    size_t total_bytes; // total bytes allocated for theories and tableau nodes, or for clauses.
+    prover_engine engine; // engine that decided the query (the winner of a portfolio).
+} prover_stats;
+
+/*
+ * Prover model is a valuation of the propositions of a factory that satisfies a query, with the propositions in
+ * increasing order of id. Propositions whose value does not matter (they do not occur on the open branch) are false.
+ */
+typedef struct prover_model
+{
+    size_t size;        // number of propositions.
+    int* propositions;  // proposition ids.
+    bool* values;       // value of each proposition.
+} prover_model;
+
+void prover_options_init(prover_options* options);
+
+bool prover_engine_parse(const char* name, prover_engine* engine);
+
+const char* prover_engine_name(prover_engine engine);
+
+prover_result is_satisfiable(formula_factory* factory, tree_node* formula, const prover_options* options,
+                             prover_stats* stats);
+
+prover_result is_valid(formula_factory* factory, tree_node* formula, const prover_options* options,
+                       prover_stats* stats);
+
+prover_result theory_satisfiable(formula_factory* factory, theory* theory, const prover_options* options,
+                                 prover_stats* stats);
+
+prover_result satisfying_model(formula_factory* factory, tree_node* formula, const prover_options* options,
+                              prover_model* model, prover_stats* stats);
+
+prover_result falsifying_model(formula_factory* factory, tree_node* formula, const prover_options* options,
+                              prover_model* model, prover_stats* stats);
+
+prover_result theory_model(formula_factory* factory, theory* theory, const prover_options* options, prover_model* model,
+                           prover_stats* stats);
+
+prover_result count_models(formula_factory* factory, tree_node* formula, const prover_options* options,
+                           uint64_t* models, prover_stats* stats);
+
+prover_result are_equivalent(formula_factory* factory, tree_node* first, tree_node* second,
+                             const prover_options* options, prover_stats* stats);
+
+void prover_model_create(prover_model* model, formula_factory* factory, const bool* valuation);
+
+void prover_model_print(const prover_model* model, FILE* output);
+
+void prover_model_free(prover_model* model);
+
+#endif //THEOREMPROVER_PROVER_H
@@ -0,0 +1,247 @@
+#include "selection.h"
+#include "tree.h"
+#include "tokenizer.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const uint64_t max_size = (uint64_t)1 << 62; // sizes of shared formulas saturate instead of overflowing.
+
+/*
+ * Selection score function ranks a formula from its number of nodes (counting shared subformulas once per occurrence)
+ * and, for a disjunction, the largest occurrence count of a proposition among its disjuncts.
+ */
+typedef uint64_t (*selection_score)(uint64_t size, uint32_t occurrences);
+
+/*
+ * Selection policy is an entry of the policy table: its name, its choose function and its score function (NULL for
+ * the policies that do not rank formulas).
+ */
+typedef struct selection_policy
+{
+    const char* name;
+    selection_choose choose;
+    selection_score score;
+} selection_policy;
+
+/*
+ * Scores a formula by its size, so the smallest beta formula is expanded first.
+ */
+static uint64_t selection_size_score(uint64_t size, uint32_t occurrences)
+{
+    (void)occurrences;
+    return size;
+}
+
+/*
+ * Scores a formula by the occurrences of its most frequent proposition (most first) and then by its size (smallest
+ * first), which approximates the MOMS heuristic of SAT solvers: branching on the clauses of the busiest variables
+ * closes the most branches early.
+ */
+static uint64_t selection_moms_score(uint64_t size, uint32_t occurrences)
+{
+    return ((uint64_t)(UINT32_MAX - occurrences) << 32) | (size < UINT32_MAX ? size : UINT32_MAX);
+}
+
+/*
+ * Chooses the beta formula with the lowest score (the most recently pushed among equal scores).
+ */
+static size_t selection_lowest(selection* selection, theory* theory)
+{
+    size_t best = 0;
+    size_t position = 0;
+    uint64_t lowest = UINT64_MAX;
+
+    for (theory_node* node = theory->betas; node != NULL; node = node->next, ++position)
+    {
+        size_t index = node->formula->index;
+        uint64_t score = index < selection->count ? selection->scores[index] : UINT64_MAX;
+        if (score < lowest)
+        {
+            lowest = score;
+            best = position;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Gets the next number of the random stream (splitmix64).
+ */
+static inline uint64_t selection_next_random(selection* selection)
+{
+    uint64_t z = (selection->random += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Chooses a beta formula uniformly at random. Without alpha formulas every non-literal is a beta formula.
+ */
+static size_t selection_uniform(selection* selection, theory* theory)
+{
+    return (size_t)(selection_next_random(selection) % theory->non_literals);
+}
+
+static const selection_policy policies[] = {
+    { "alpha-first", NULL, NULL },
+    { "smallest-beta", selection_lowest, selection_size_score },
+    { "moms", selection_lowest, selection_moms_score },
+    { "random", selection_uniform, NULL },
+};
+
+/*
+ * Parses a policy name, returning false if the name is not a policy.
+ */
+bool selection_parse(const char* name, selection_kind* kind)
+{
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+    {
+        if (strcmp(name, policies[i].name) == 0)
+        {
+            *kind = (selection_kind)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Gets the name of a policy.
+ */
+const char* selection_name(selection_kind kind)
+{
+    return policies[kind].name;
+}
+
+/*
+ * Gets the proposition id of a literal.
+ */
+static inline int selection_literal_id(tree_node* literal)
+{
+    return literal->token.type == proposition ? literal->token.id : literal->left_child->token.id;
+}
+
+/*
+ * Checks if a formula is a disjunction.
+ */
+static inline bool selection_is_disjunction(tree_node* formula)
+{
+    return formula->token.type == binary_connective && is_or_connective(formula->token.symbol);
+}
+
+/*
+ * Scores the formulas reachable from the root theory. Subformulas are created before the formulas that contain them,
+ * so a subformula has a lower node index than its parents and one pass in index order visits the operands of every
+ * formula before the formula (without recursion).
+ */
+static void selection_rank(selection* selection, selection_score score, formula_factory* factory, theory* root)
+{
+    size_t count = factory->size;
+    tree_node** nodes = theory_subformulas(root, count);
+
+    // A proposition occurs once for each formula that has one of its literals as an operand.
+    uint32_t* occurrences = (uint32_t*)calloc((size_t)symbol_count() + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (nodes[i] == NULL || nodes[i]->token.type != binary_connective) { continue; }
+
+        tree_node* children[2] = { nodes[i]->left_child, nodes[i]->right_child };
+        for (int j = 0; j < 2; ++j)
+        {
+            if (!is_literal(children[j])) { continue; }
+
+            uint32_t* counter = &occurrences[selection_literal_id(children[j])];
+            if (*counter < UINT32_MAX) { ++*counter; }
+        }
+    }
+
+    uint64_t* sizes = (uint64_t*)calloc(count, sizeof(uint64_t));
+    uint32_t* busiest = (uint32_t*)calloc(count, sizeof(uint32_t)); // largest occurrences among the disjuncts.
+    selection->scores = (uint64_t*)calloc(count, sizeof(uint64_t));
+    selection->count = count;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        tree_node* formula = nodes[i];
+        if (formula == NULL) { continue; }
+
+        uint64_t size = 1;
+        if (formula->left_child != NULL) { size += sizes[formula->left_child->index]; }
+        if (formula->right_child != NULL) { size += sizes[formula->right_child->index]; }
+        sizes[i] = size < max_size ? size : max_size;
+
+        if (selection_is_disjunction(formula))
+        {
+            tree_node* children[2] = { formula->left_child, formula->right_child };
+            for (int j = 0; j < 2; ++j)
+            {
+                uint32_t busy = 0;
+                if (is_literal(children[j])) { busy = occurrences[selection_literal_id(children[j])]; }
+                else if (selection_is_disjunction(children[j])) { busy = busiest[children[j]->index]; }
+                if (busy > busiest[i]) { busiest[i] = busy; }
+            }
+        }
+
+        selection->scores[i] = score(sizes[i], busiest[i]);
+    }
+
+    free(busiest);
+    free(sizes);
+    free(occurrences);
+    free(nodes);
+}
+
+/*
+ * Initializes the selection of a search for the root theory (in negation normal form, with its formulas in the
+ * factory) with a policy and the seed of its random stream.
+ */
+void selection_init(selection* selection, selection_kind kind, uint64_t seed, formula_factory* factory, theory* root)
+{
+    selection->kind = kind;
+    selection->choose = policies[kind].choose;
+    selection->scores = NULL;
+    selection->count = 0;
+    selection->random = seed;
+
+    if (policies[kind].score != NULL) { selection_rank(selection, policies[kind].score, factory, root); }
+}
+
+/*
+ * Makes a copy of a selection for a worker, with its own random stream. The copy shares the scores of the selection,
+ * so it must not be destroyed and must not outlive the selection.
+ */
+void selection_fork(selection* copy, const selection* selection, uint64_t stream)
+{
+    *copy = *selection;
+    copy->random = selection->random + stream * 0xd1b54a32d192ed03ULL;
+}
+
+/*
+ * Frees the scores of a selection.
+ */
+void selection_destroy(selection* selection)
+{
+    free(selection->scores);
+    selection->scores = NULL;
+    selection->count = 0;
+}
+
+/*
+ * Removes the next non-literal formula to expand from the theory and returns it: an alpha formula if there is one,
+ * otherwise the beta formula chosen by the policy. The position of a beta formula in the beta list is stored in
+ * position (0 for an alpha formula), so a search that changes the theory in place can restore it with
+ * theory_restore_beta.
+ */
+tree_node* selection_pick(selection* selection, theory* theory, size_t* position)
+{
+    *position = 0;
+    if (theory->alphas != NULL || selection->choose == NULL) { return theory_pick_non_literal(theory); }
+
+    *position = selection->choose(selection, theory);
+    return theory_pick_beta(theory, *position);
+}
@@ -0,0 +1,58 @@
+#ifndef THEOREMPROVER_SELECTION_H
+#define THEOREMPROVER_SELECTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "factory.h"
+#include "theory.h"
+
+/*
+ * Selection policies of the tableau engines. Every policy expands alpha formulas first, since they never branch, and
+ * differs in the beta formula it expands when the theory has no alpha formula left.
+ */
+typedef enum selection_kind
+{
+    select_alpha_first,     // the most recently pushed beta formula (constant time).
+    select_smallest_beta,   // the beta formula with the fewest nodes.
+    select_moms,            // the beta formula with the most frequent proposition among its disjuncts (MOMS-like).
+    select_random           // a beta formula chosen uniformly with a seeded generator.
+} selection_kind;
+
+typedef struct selection selection;
+
+/*
+ * Selection choose function returns the position in the beta list (0 for the most recently pushed) of the beta
+ * formula to expand next, given a theory with beta formulas and no alpha formula. Picking the formula at position k
+ * (and restoring it on backtracking) walks k list nodes and swaps it with the front formula without allocating, except
+ * that the first pick after the theory was copied copies the k + 1 nodes it shares with the copy.
+ */
+typedef size_t (*selection_choose)(selection* selection, theory* theory);
+
+/*
+ * Selection is the policy of one search. Scored policies rank the formulas of the query once, when the selection is
+ * initialized, by node index (the formulas of a search are never created during the search), so choosing only scans
+ * the beta list. A worker of a parallel search uses a copy with its own random stream, sharing the scores.
+ */
+struct selection
+{
+    selection_kind kind;
+    selection_choose choose;    // NULL for the most recently pushed beta formula.
+    uint64_t* scores;           // score of each formula by node index (the lowest score is expanded first).
+    size_t count;               // number of scores.
+    uint64_t random;            // state of the random generator.
+};
+
+bool selection_parse(const char* name, selection_kind* kind);
+
+const char* selection_name(selection_kind kind);
+
+void selection_init(selection* selection, selection_kind kind, uint64_t seed, formula_factory* factory, theory* root);
+
+void selection_fork(selection* copy, const selection* selection, uint64_t stream);
+
+void selection_destroy(selection* selection);
+
+tree_node* selection_pick(selection* selection, theory* theory, size_t* position);
+
+#endif //THEOREMPROVER_SELECTION_H
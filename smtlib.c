@@ -0,0 +1,1130 @@
+#include "smtlib.h"
+#include "context.h"
+#include "tree.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * SMT-LIB token types. Numerals include decimals, which no supported command uses but which must still be skipped.
+ */
+typedef enum smtlib_token
+{
+    smtlib_open,
+    smtlib_close,
+    smtlib_symbol,
+    smtlib_keyword,
+    smtlib_numeral,
+    smtlib_string,
+    smtlib_eof,
+    smtlib_invalid
+} smtlib_token;
+
+/*
+ * Boolean functions of the core theory.
+ */
+typedef enum smtlib_function
+{
+    function_not,
+    function_and,
+    function_or,
+    function_implies,
+    function_xor,
+    function_equals,
+    function_distinct,
+    function_ite
+} smtlib_function;
+
+static const char* function_names[] = {"not", "and", "or", "=>", "xor", "=", "distinct", "ite"};
+
+/*
+ * Terms are parsed without recursion: each open application, let or annotation is a frame of an explicit stack, and
+ * the arguments of the open applications share one value stack.
+ */
+typedef enum smtlib_frame_type
+{
+    frame_apply,        // (f t1 ... tn): the arguments are on the value stack from first.
+    frame_bindings,     // (let ((x1 t1) ... (xn tn)) ...): the bindings read so far are pending from first.
+    frame_body,         // the body of a let, whose bindings are in scope above mark on the undo stack.
+    frame_annotation    // (! t :attribute ...).
+} smtlib_frame_type;
+
+typedef struct smtlib_frame
+{
+    smtlib_frame_type type;
+    smtlib_function function;
+    size_t first;
+    size_t mark;
+    int name;           // symbol id of the binding being read.
+} smtlib_frame;
+
+/*
+ * Binding of a symbol to a formula: a pending let binding, or the previous binding of a symbol shadowed by a let.
+ */
+typedef struct smtlib_binding
+{
+    int id;
+    tree_node* formula;
+} smtlib_binding;
+
+/*
+ * SMT-LIB reader streams a script through a fixed size buffer and answers each command as soon as it is read.
+ * Names are resolved by symbol id: let bindings first, then defined names, then declared constants.
+ */
+typedef struct smtlib_reader
+{
+    FILE* input;
+    FILE* output;
+    char buffer[1 << 16];
+    size_t position;
+    size_t length;
+    smtlib_token token;     // current token, or the peeked token if peeked is set.
+    bool peeked;
+    char* text;             // text of the current symbol, keyword, numeral or string.
+    size_t text_length;
+    size_t text_capacity;
+    int depth;              // parentheses open in the current command.
+    solver_context* context;
+    size_t names;           // capacity of the name arrays (in symbol ids).
+    tree_node** lets;
+    tree_node** definitions;
+    bool* declared;
+    int* declarations;      // declared names in declaration order.
+    size_t declaration_count;
+    smtlib_frame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    tree_node** values;
+    size_t value_count;
+    size_t value_capacity;
+    smtlib_binding* pending;
+    size_t pending_count;
+    size_t pending_capacity;
+    smtlib_binding* undo;
+    size_t undo_count;
+    size_t undo_capacity;
+    bool checked;           // a check has been made since the assertions last changed.
+    bool exit;
+    int errors;
+} smtlib_reader;
+
+/*
+ * Grows a growable array so that it can hold one more element.
+ */
+static void* smtlib_reserve(void* items, size_t count, size_t* capacity, size_t size)
+{
+    if (count < *capacity) { return items; }
+
+    *capacity = *capacity > 0 ? 2 * *capacity : 16;
+    return realloc(items, *capacity * size);
+}
+
+/*
+ * Gets the next character of the input, refilling the buffer when it runs out (EOF at the end of the input).
+ */
+static inline int smtlib_next(smtlib_reader* reader)
+{
+    if (reader->position == reader->length)
+    {
+        reader->length = fread(reader->buffer, 1, sizeof(reader->buffer), reader->input);
+        reader->position = 0;
+        if (reader->length == 0) { return EOF; }
+    }
+
+    return (unsigned char)reader->buffer[reader->position++];
+}
+
+/*
+ * Gets the next character of the input without consuming it.
+ */
+static inline int smtlib_peek_char(smtlib_reader* reader)
+{
+    int c = smtlib_next(reader);
+    if (c != EOF) { --reader->position; }
+    return c;
+}
+
+/*
+ * Checks if the character is a whitespace (including new lines).
+ */
+static inline bool smtlib_is_space(int c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/*
+ * Checks if the character ends a simple symbol, keyword or numeral.
+ */
+static inline bool smtlib_is_delimiter(int c)
+{
+    return c == EOF || smtlib_is_space(c) || c == '(' || c == ')' || c == '|' || c == '"' || c == ';';
+}
+
+/*
+ * Appends a character to the token text.
+ */
+static void smtlib_append(smtlib_reader* reader, int c)
+{
+    if (reader->text_length + 1 >= reader->text_capacity)
+    {
+        reader->text_capacity = reader->text_capacity > 0 ? 2 * reader->text_capacity : 64;
+        reader->text = (char*)realloc(reader->text, reader->text_capacity);
+    }
+
+    reader->text[reader->text_length++] = (char)c;
+    reader->text[reader->text_length] = '\0';
+}
+
+/*
+ * Reads the next token of the input, skipping whitespace and comments.
+ */
+static smtlib_token smtlib_lex(smtlib_reader* reader)
+{
+    int c = smtlib_next(reader);
+    while (smtlib_is_space(c) || c == ';')
+    {
+        if (c == ';')
+        {
+            do { c = smtlib_next(reader); } while (c != '\n' && c != EOF);
+        }
+        c = smtlib_next(reader);
+    }
+
+    reader->text_length = 0;
+    reader->text[0] = '\0';
+
+    if (c == EOF) { return smtlib_eof; }
+    if (c == '(') { return smtlib_open; }
+    if (c == ')') { return smtlib_close; }
+
+    if (c == '|')
+    {
+        // quoted symbol: any characters up to the closing bar, which are not part of the name.
+        while ((c = smtlib_next(reader)) != '|')
+        {
+            if (c == EOF) { return smtlib_invalid; }
+            smtlib_append(reader, c);
+        }
+        return smtlib_symbol;
+    }
+
+    if (c == '"')
+    {
+        // string literal: a doubled quote stands for a quote.
+        while (true)
+        {
+            c = smtlib_next(reader);
+            if (c == EOF) { return smtlib_invalid; }
+            if (c == '"')
+            {
+                if (smtlib_peek_char(reader) != '"') { return smtlib_string; }
+                smtlib_next(reader);
+            }
+            smtlib_append(reader, c);
+        }
+    }
+
+    smtlib_token type = c == ':' ? smtlib_keyword : (c >= '0' && c <= '9' ? smtlib_numeral : smtlib_symbol);
+    smtlib_append(reader, c);
+    while (!smtlib_is_delimiter(smtlib_peek_char(reader)))
+    {
+        smtlib_append(reader, smtlib_next(reader));
+    }
+
+    return type;
+}
+
+/*
+ * Gets the next token without consuming it.
+ */
+static smtlib_token smtlib_peek(smtlib_reader* reader)
+{
+    if (!reader->peeked)
+    {
+        reader->token = smtlib_lex(reader);
+        reader->peeked = true;
+    }
+
+    return reader->token;
+}
+
+/*
+ * Consumes the next token, keeping track of the parentheses open in the current command.
+ */
+static smtlib_token smtlib_token_next(smtlib_reader* reader)
+{
+    smtlib_token type = smtlib_peek(reader);
+    reader->peeked = false;
+
+    if (type == smtlib_open) { ++reader->depth; }
+    if (type == smtlib_close) { --reader->depth; }
+    return type;
+}
+
+/*
+ * Reports an error in the current command.
+ */
+static void smtlib_error(smtlib_reader* reader, const char* message)
+{
+    fprintf(reader->output, "(error \"%s\")\n", message);
+    ++reader->errors;
+}
+
+/*
+ * Skips the rest of the current command after an error.
+ */
+static void smtlib_skip_command(smtlib_reader* reader)
+{
+    while (reader->depth > 0 && smtlib_token_next(reader) != smtlib_eof) {}
+    reader->depth = 0;
+}
+
+/*
+ * Consumes the closing parenthesis of a command, reporting an error if anything else follows.
+ */
+static bool smtlib_expect_close(smtlib_reader* reader)
+{
+    if (smtlib_token_next(reader) != smtlib_close)
+    {
+        smtlib_error(reader, "unexpected input at the end of the command");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Consumes a symbol, interning its name in id. Reports an error if the next token is not a symbol.
+ */
+static bool smtlib_expect_symbol(smtlib_reader* reader, int* id)
+{
+    if (smtlib_token_next(reader) != smtlib_symbol)
+    {
+        smtlib_error(reader, "expected a symbol");
+        return false;
+    }
+
+    *id = symbol_intern(reader->text, reader->text_length);
+    return true;
+}
+
+/*
+ * Checks if the text of the current token is the given word.
+ */
+static inline bool smtlib_is(smtlib_reader* reader, const char* word)
+{
+    return strcmp(reader->text, word) == 0;
+}
+
+/*
+ * Grows the name arrays so that they can hold the symbol id.
+ */
+static void smtlib_reserve_name(smtlib_reader* reader, int id)
+{
+    if ((size_t)id < reader->names) { return; }
+
+    size_t capacity = reader->names > 0 ? reader->names : 256;
+    while (capacity <= (size_t)id) { capacity *= 2; }
+
+    reader->lets = (tree_node**)realloc(reader->lets, capacity * sizeof(tree_node*));
+    reader->definitions = (tree_node**)realloc(reader->definitions, capacity * sizeof(tree_node*));
+    reader->declared = (bool*)realloc(reader->declared, capacity * sizeof(bool));
+    memset(reader->lets + reader->names, 0, (capacity - reader->names) * sizeof(tree_node*));
+    memset(reader->definitions + reader->names, 0, (capacity - reader->names) * sizeof(tree_node*));
+    memset(reader->declared + reader->names, 0, (capacity - reader->names) * sizeof(bool));
+    reader->names = capacity;
+}
+
+/*
+ * Checks if a name is already declared or defined.
+ */
+static bool smtlib_is_bound(smtlib_reader* reader, int id)
+{
+    smtlib_reserve_name(reader, id);
+    return reader->declared[id] || reader->definitions[id] != NULL;
+}
+
+/*
+ * Gets the negation of a formula.
+ */
+static tree_node* smtlib_not(smtlib_reader* reader, tree_node* formula)
+{
+    token negated;
+    token_init(&negated, negation, '-');
+    return negated_formula(reader->context->factory, negated, formula);
+}
+
+/*
+ * Gets the binary formula of two formulas with the connective symbol ('^', 'v' or '>').
+ */
+static tree_node* smtlib_binary(smtlib_reader* reader, char symbol, tree_node* left, tree_node* right)
+{
+    token connective;
+    token_init(&connective, binary_connective, symbol);
+    return binary_formula(reader->context->factory, connective, left, right);
+}
+
+/*
+ * Gets the constant true (the negation of the contradiction (_false ^ -_false)) or false.
+ */
+static tree_node* smtlib_constant(smtlib_reader* reader, bool value)
+{
+    token prop;
+    token_init_proposition(&prop, symbol_intern("_false", 6));
+    tree_node* node = proposition_formula(reader->context->factory, prop);
+    tree_node* contradiction = smtlib_binary(reader, '^', node, smtlib_not(reader, node));
+    return value ? smtlib_not(reader, contradiction) : contradiction;
+}
+
+/*
+ * Gets the equivalence of two formulas as a conjunction of implications.
+ */
+static tree_node* smtlib_iff(smtlib_reader* reader, tree_node* left, tree_node* right)
+{
+    return smtlib_binary(reader, '^', smtlib_binary(reader, '>', left, right), smtlib_binary(reader, '>', right, left));
+}
+
+/*
+ * Resolves the name of the current symbol token to its formula, or returns NULL and reports an error if the name is
+ * unknown.
+ */
+static tree_node* smtlib_resolve(smtlib_reader* reader)
+{
+    if (smtlib_is(reader, "true")) { return smtlib_constant(reader, true); }
+    if (smtlib_is(reader, "false")) { return smtlib_constant(reader, false); }
+
+    int id = symbol_intern(reader->text, reader->text_length);
+    smtlib_reserve_name(reader, id);
+
+    if (reader->lets[id] != NULL) { return reader->lets[id]; }
+    if (reader->definitions[id] != NULL) { return reader->definitions[id]; }
+
+    if (reader->declared[id])
+    {
+        token prop;
+        token_init_proposition(&prop, id);
+        return proposition_formula(reader->context->factory, prop);
+    }
+
+    smtlib_error(reader, "unknown constant");
+    return NULL;
+}
+
+/*
+ * Applies the function of an application frame to its arguments on the value stack, popping them.
+ * Returns NULL and reports an error if the number of arguments does not fit the function.
+ */
+static tree_node* smtlib_apply(smtlib_reader* reader, smtlib_frame* frame)
+{
+    tree_node** arguments = reader->values + frame->first;
+    size_t count = reader->value_count - frame->first;
+    reader->value_count = frame->first;
+
+    tree_node* result = NULL;
+    switch (frame->function)
+    {
+        case function_not:
+            if (count == 1) { result = smtlib_not(reader, arguments[0]); }
+            break;
+        case function_and:
+        case function_or:
+            result = smtlib_constant(reader, frame->function == function_and);
+            if (count > 0) { result = arguments[0]; }
+            for (size_t i = 1; i < count; ++i)
+            {
+                result = smtlib_binary(reader, frame->function == function_and ? '^' : 'v', result, arguments[i]);
+            }
+            break;
+        case function_implies:
+            // right associative: (=> a b c) is (=> a (=> b c)).
+            if (count >= 2)
+            {
+                result = arguments[count - 1];
+                for (size_t i = count - 1; i-- > 0;) { result = smtlib_binary(reader, '>', arguments[i], result); }
+            }
+            break;
+        case function_xor:
+            // left associative: (xor a b c) is (xor (xor a b) c).
+            if (count >= 2)
+            {
+                result = arguments[0];
+                for (size_t i = 1; i < count; ++i)
+                {
+                    result = smtlib_not(reader, smtlib_iff(reader, result, arguments[i]));
+                }
+            }
+            break;
+        case function_equals:
+            // chainable: (= a b c) is (and (= a b) (= b c)).
+            if (count >= 2)
+            {
+                result = smtlib_iff(reader, arguments[0], arguments[1]);
+                for (size_t i = 2; i < count; ++i)
+                {
+                    result = smtlib_binary(reader, '^', result, smtlib_iff(reader, arguments[i - 1], arguments[i]));
+                }
+            }
+            break;
+        case function_distinct:
+            // pairwise: every two arguments differ.
+            if (count >= 2)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (size_t j = i + 1; j < count; ++j)
+                    {
+                        tree_node* differ = smtlib_not(reader, smtlib_iff(reader, arguments[i], arguments[j]));
+                        result = result == NULL ? differ : smtlib_binary(reader, '^', result, differ);
+                    }
+                }
+            }
+            break;
+        case function_ite:
+            if (count == 3)
+            {
+                result = smtlib_binary(reader, '^', smtlib_binary(reader, '>', arguments[0], arguments[1]),
+                                       smtlib_binary(reader, '>', smtlib_not(reader, arguments[0]), arguments[2]));
+            }
+            break;
+    }
+
+    if (result == NULL) { smtlib_error(reader, "wrong number of arguments"); }
+    return result;
+}
+
+/*
+ * Pushes a frame of the given type.
+ */
+static smtlib_frame* smtlib_push_frame(smtlib_reader* reader, smtlib_frame_type type)
+{
+    reader->frames = (smtlib_frame*)smtlib_reserve(reader->frames, reader->frame_count, &reader->frame_capacity,
+                                                   sizeof(smtlib_frame));
+    smtlib_frame* frame = &reader->frames[reader->frame_count++];
+    memset(frame, 0, sizeof(*frame));
+    frame->type = type;
+    return frame;
+}
+
+/*
+ * Starts the next binding of a let frame, or brings the pending bindings into scope and starts the body of the let if
+ * the binding list is closed. Returns false and reports an error if neither follows.
+ */
+static bool smtlib_let_next(smtlib_reader* reader, smtlib_frame* frame)
+{
+    smtlib_token type = smtlib_token_next(reader);
+
+    if (type == smtlib_open) { return smtlib_expect_symbol(reader, &frame->name); }
+
+    if (type != smtlib_close)
+    {
+        smtlib_error(reader, "expected a binding");
+        return false;
+    }
+
+    // The bindings of one let are parallel: they are all read before any of them comes into scope.
+    frame->mark = reader->undo_count;
+    for (size_t i = frame->first; i < reader->pending_count; ++i)
+    {
+        smtlib_binding binding = reader->pending[i];
+        smtlib_reserve_name(reader, binding.id);
+
+        reader->undo = (smtlib_binding*)smtlib_reserve(reader->undo, reader->undo_count, &reader->undo_capacity,
+                                                       sizeof(smtlib_binding));
+        reader->undo[reader->undo_count].id = binding.id;
+        reader->undo[reader->undo_count++].formula = reader->lets[binding.id];
+        reader->lets[binding.id] = binding.formula;
+    }
+
+    reader->pending_count = frame->first;
+    frame->type = frame_body;
+    return true;
+}
+
+/*
+ * Restores the let bindings shadowed since the undo stack had the given size.
+ */
+static void smtlib_unbind(smtlib_reader* reader, size_t mark)
+{
+    while (reader->undo_count > mark)
+    {
+        smtlib_binding binding = reader->undo[--reader->undo_count];
+        reader->lets[binding.id] = binding.formula;
+    }
+}
+
+/*
+ * Skips an attribute value (a constant, a symbol or a parenthesized expression), if there is one.
+ */
+static bool smtlib_skip_value(smtlib_reader* reader)
+{
+    smtlib_token type = smtlib_peek(reader);
+    if (type == smtlib_close || type == smtlib_keyword) { return true; }
+
+    int depth = reader->depth;
+    do
+    {
+        type = smtlib_token_next(reader);
+        if (type == smtlib_eof || type == smtlib_invalid) { return false; }
+    } while (reader->depth > depth);
+
+    return true;
+}
+
+/*
+ * Reads the attributes of an annotation up to its closing parenthesis. A :named attribute defines its name as the
+ * annotated formula. Other attributes are ignored.
+ */
+static bool smtlib_annotate(smtlib_reader* reader, tree_node* formula)
+{
+    smtlib_token type;
+    while ((type = smtlib_token_next(reader)) == smtlib_keyword)
+    {
+        if (smtlib_is(reader, ":named"))
+        {
+            int id;
+            if (!smtlib_expect_symbol(reader, &id)) { return false; }
+            if (smtlib_is_bound(reader, id))
+            {
+                smtlib_error(reader, "name is already declared");
+                return false;
+            }
+
+            reader->definitions[id] = formula;
+        }
+        else if (!smtlib_skip_value(reader))
+        {
+            smtlib_error(reader, "malformed attribute");
+            return false;
+        }
+    }
+
+    if (type != smtlib_close)
+    {
+        smtlib_error(reader, "malformed annotation");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Reads a Boolean term and translates it to a formula of the context factory. Returns NULL and reports an error if
+ * the term is malformed, in which case the rest of the command is left to be skipped.
+ */
+static tree_node* smtlib_term(smtlib_reader* reader)
+{
+    size_t frames = reader->frame_count;
+    size_t values = reader->value_count;
+    size_t pending = reader->pending_count;
+    size_t undo = reader->undo_count;
+
+    tree_node* formula = NULL;
+    bool complete = false; // formula is a complete term to be passed to the innermost frame.
+
+    while (true)
+    {
+        if (!complete)
+        {
+            smtlib_token type = smtlib_token_next(reader);
+
+            if (type == smtlib_symbol)
+            {
+                formula = smtlib_resolve(reader);
+                if (formula == NULL) { break; }
+                complete = true;
+            }
+            else if (type == smtlib_open)
+            {
+                if (smtlib_token_next(reader) != smtlib_symbol)
+                {
+                    smtlib_error(reader, "expected a function symbol");
+                    break;
+                }
+
+                if (smtlib_is(reader, "let"))
+                {
+                    if (smtlib_token_next(reader) != smtlib_open)
+                    {
+                        smtlib_error(reader, "expected a binding list");
+                        break;
+                    }
+
+                    smtlib_frame* frame = smtlib_push_frame(reader, frame_bindings);
+                    frame->first = reader->pending_count;
+                    if (!smtlib_let_next(reader, frame)) { break; }
+                    continue;
+                }
+
+                if (smtlib_is(reader, "!"))
+                {
+                    smtlib_push_frame(reader, frame_annotation);
+                    continue;
+                }
+
+                size_t function = 0;
+                while (function < sizeof(function_names) / sizeof(function_names[0]) &&
+                       !smtlib_is(reader, function_names[function]))
+                {
+                    ++function;
+                }
+
+                if (function == sizeof(function_names) / sizeof(function_names[0]))
+                {
+                    smtlib_error(reader, "unsupported function");
+                    break;
+                }
+
+                smtlib_frame* frame = smtlib_push_frame(reader, frame_apply);
+                frame->function = (smtlib_function)function;
+                frame->first = reader->value_count;
+
+                if (smtlib_peek(reader) != smtlib_close) { continue; }
+
+                // an application without arguments, such as (and).
+                smtlib_token_next(reader);
+                formula = smtlib_apply(reader, frame);
+                --reader->frame_count;
+                if (formula == NULL) { break; }
+                complete = true;
+            }
+            else
+            {
+                smtlib_error(reader, "expected a term");
+                break;
+            }
+        }
+
+        if (reader->frame_count == frames) { return formula; }
+
+        smtlib_frame* frame = &reader->frames[reader->frame_count - 1];
+        if (frame->type == frame_apply)
+        {
+            reader->values = (tree_node**)smtlib_reserve(reader->values, reader->value_count, &reader->value_capacity,
+                                                         sizeof(tree_node*));
+            reader->values[reader->value_count++] = formula;
+
+            complete = smtlib_peek(reader) == smtlib_close;
+            if (complete)
+            {
+                smtlib_token_next(reader);
+                formula = smtlib_apply(reader, frame);
+                --reader->frame_count;
+                if (formula == NULL) { break; }
+            }
+        }
+        else if (frame->type == frame_bindings)
+        {
+            reader->pending = (smtlib_binding*)smtlib_reserve(reader->pending, reader->pending_count,
+                                                              &reader->pending_capacity, sizeof(smtlib_binding));
+            reader->pending[reader->pending_count].id = frame->name;
+            reader->pending[reader->pending_count++].formula = formula;
+
+            if (smtlib_token_next(reader) != smtlib_close)
+            {
+                smtlib_error(reader, "malformed binding");
+                break;
+            }
+
+            if (!smtlib_let_next(reader, frame)) { break; }
+            complete = false;
+        }
+        else if (frame->type == frame_body)
+        {
+            if (smtlib_token_next(reader) != smtlib_close)
+            {
+                smtlib_error(reader, "malformed let");
+                break;
+            }
+
+            smtlib_unbind(reader, frame->mark);
+            --reader->frame_count;
+        }
+        else
+        {
+            if (!smtlib_annotate(reader, formula)) { break; }
+            --reader->frame_count;
+        }
+    }
+
+    // The term is malformed: the state of its open frames is dropped.
+    smtlib_unbind(reader, undo);
+    reader->frame_count = frames;
+    reader->value_count = values;
+    reader->pending_count = pending;
+    return NULL;
+}
+
+/*
+ * Reads the sort of a constant, reporting an error if it is not Bool.
+ */
+static bool smtlib_expect_bool(smtlib_reader* reader)
+{
+    if (smtlib_token_next(reader) != smtlib_symbol || !smtlib_is(reader, "Bool"))
+    {
+        smtlib_error(reader, "only Bool constants are supported");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Reads the name of a new constant or definition, reporting an error if the name is already in use.
+ */
+static bool smtlib_new_name(smtlib_reader* reader, int* id)
+{
+    if (!smtlib_expect_symbol(reader, id)) { return false; }
+
+    if (smtlib_is_bound(reader, *id) || smtlib_is(reader, "true") || smtlib_is(reader, "false"))
+    {
+        smtlib_error(reader, "name is already declared");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Reads an empty parameter list (only constants are supported).
+ */
+static bool smtlib_expect_no_parameters(smtlib_reader* reader)
+{
+    if (smtlib_token_next(reader) != smtlib_open || smtlib_token_next(reader) != smtlib_close)
+    {
+        smtlib_error(reader, "only constants are supported");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Reads an optional numeral argument of push or pop (1 if it is omitted).
+ */
+static bool smtlib_count(smtlib_reader* reader, long* count)
+{
+    *count = 1;
+    if (smtlib_peek(reader) == smtlib_close) { return true; }
+
+    if (smtlib_token_next(reader) != smtlib_numeral || strspn(reader->text, "0123456789") != reader->text_length)
+    {
+        smtlib_error(reader, "expected a numeral");
+        return false;
+    }
+
+    *count = strtol(reader->text, NULL, 10);
+    return true;
+}
+
+/*
+ * Prints a name as a symbol, quoting it if it is not a simple symbol.
+ */
+static void smtlib_print_name(FILE* output, int id)
+{
+    const char* name = symbol_name(id);
+    size_t length = symbol_length(id);
+
+    bool simple = length > 0 && !(name[0] >= '0' && name[0] <= '9');
+    for (size_t i = 0; i < length && simple; ++i)
+    {
+        char c = name[i];
+        simple = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                 strchr("~!@$%^&*_-+=<>.?/", c) != NULL;
+    }
+
+    fprintf(output, simple ? "%.*s" : "|%.*s|", (int)length, name);
+}
+
+/*
+ * Checks the assertions, under the assumptions if any, and prints the result.
+ */
+static void smtlib_check(smtlib_reader* reader, tree_node** assumptions, size_t count)
+{
+    bool satisfiable = context_check(reader->context, assumptions, count, NULL);
+    fprintf(reader->output, satisfiable ? "sat\n" : "unsat\n");
+    reader->checked = true;
+}
+
+/*
+ * Prints the model of the last check as a definition of every declared constant.
+ */
+static bool smtlib_get_model(smtlib_reader* reader)
+{
+    if (!reader->checked || !reader->context->satisfiable)
+    {
+        smtlib_error(reader, "model is not available");
+        return false;
+    }
+
+    fprintf(reader->output, "(\n");
+    for (size_t i = 0; i < reader->declaration_count; ++i)
+    {
+        int id = reader->declarations[i];
+        fprintf(reader->output, "  (define-fun ");
+        smtlib_print_name(reader->output, id);
+        fprintf(reader->output, " () Bool %s)\n", context_value(reader->context, id) ? "true" : "false");
+    }
+    fprintf(reader->output, ")\n");
+    return true;
+}
+
+/*
+ * Discards every assertion, scope, declaration and definition.
+ */
+static void smtlib_reset(smtlib_reader* reader)
+{
+    context_free(reader->context);
+    reader->context = context_create();
+
+    memset(reader->lets, 0, reader->names * sizeof(tree_node*));
+    memset(reader->definitions, 0, reader->names * sizeof(tree_node*));
+    memset(reader->declared, 0, reader->names * sizeof(bool));
+    reader->declaration_count = 0;
+    reader->checked = false;
+}
+
+/*
+ * Reads and answers one command whose opening parenthesis has been read. Returns false if the command is malformed,
+ * in which case the rest of the command is left to be skipped.
+ */
+static bool smtlib_command(smtlib_reader* reader)
+{
+    if (smtlib_token_next(reader) != smtlib_symbol)
+    {
+        smtlib_error(reader, "expected a command");
+        return false;
+    }
+
+    if (smtlib_is(reader, "assert"))
+    {
+        tree_node* formula = smtlib_term(reader);
+        if (formula == NULL || !smtlib_expect_close(reader)) { return false; }
+
+        context_assert(reader->context, formula);
+        reader->checked = false;
+        return true;
+    }
+
+    if (smtlib_is(reader, "check-sat"))
+    {
+        if (!smtlib_expect_close(reader)) { return false; }
+
+        smtlib_check(reader, NULL, 0);
+        return true;
+    }
+
+    if (smtlib_is(reader, "check-sat-assuming"))
+    {
+        if (smtlib_token_next(reader) != smtlib_open)
+        {
+            smtlib_error(reader, "expected a list of assumptions");
+            return false;
+        }
+
+        tree_node** assumptions = NULL;
+        size_t count = 0;
+        size_t capacity = 0;
+        while (smtlib_peek(reader) != smtlib_close)
+        {
+            tree_node* formula = smtlib_term(reader);
+            if (formula == NULL)
+            {
+                free(assumptions);
+                return false;
+            }
+
+            assumptions = (tree_node**)smtlib_reserve(assumptions, count, &capacity, sizeof(tree_node*));
+            assumptions[count++] = formula;
+        }
+
+        smtlib_token_next(reader);
+        bool closed = smtlib_expect_close(reader);
+        if (closed) { smtlib_check(reader, assumptions, count); }
+        free(assumptions);
+        return closed;
+    }
+
+    if (smtlib_is(reader, "declare-const") || smtlib_is(reader, "declare-fun"))
+    {
+        bool function = smtlib_is(reader, "declare-fun");
+        int id;
+        if (!smtlib_new_name(reader, &id) || (function && !smtlib_expect_no_parameters(reader)) ||
+            !smtlib_expect_bool(reader) || !smtlib_expect_close(reader))
+        {
+            return false;
+        }
+
+        reader->declared[id] = true;
+        reader->declarations = (int*)realloc(reader->declarations, (reader->declaration_count + 1) * sizeof(int));
+        reader->declarations[reader->declaration_count++] = id;
+        return true;
+    }
+
+    if (smtlib_is(reader, "define-fun"))
+    {
+        int id;
+        if (!smtlib_new_name(reader, &id) || !smtlib_expect_no_parameters(reader) || !smtlib_expect_bool(reader))
+        {
+            return false;
+        }
+
+        tree_node* formula = smtlib_term(reader);
+        if (formula == NULL || !smtlib_expect_close(reader)) { return false; }
+
+        reader->definitions[id] = formula;
+        return true;
+    }
+
+    if (smtlib_is(reader, "push") || smtlib_is(reader, "pop"))
+    {
+        bool push = smtlib_is(reader, "push");
+        long count;
+        if (!smtlib_count(reader, &count) || !smtlib_expect_close(reader)) { return false; }
+
+        if (!push && (size_t)count > context_scopes(reader->context))
+        {
+            smtlib_error(reader, "not enough scopes to pop");
+            return true;
+        }
+
+        for (long i = 0; i < count; ++i)
+        {
+            if (push) { context_push(reader->context); }
+            else { context_pop(reader->context); }
+        }
+
+        reader->checked = false;
+        return true;
+    }
+
+    if (smtlib_is(reader, "get-model"))
+    {
+        return smtlib_expect_close(reader) && smtlib_get_model(reader);
+    }
+
+    if (smtlib_is(reader, "set-logic"))
+    {
+        if (smtlib_token_next(reader) != smtlib_symbol)
+        {
+            smtlib_error(reader, "expected a logic");
+            return false;
+        }
+
+        bool supported = smtlib_is(reader, "QF_BOOL") || smtlib_is(reader, "QF_UF") || smtlib_is(reader, "ALL");
+        if (!smtlib_expect_close(reader)) { return false; }
+
+        if (!supported) { fprintf(reader->output, "unsupported\n"); }
+        return true;
+    }
+
+    if (smtlib_is(reader, "set-option") || smtlib_is(reader, "set-info"))
+    {
+        smtlib_skip_command(reader); // options and information do not change the answers.
+        return true;
+    }
+
+    if (smtlib_is(reader, "echo"))
+    {
+        if (smtlib_token_next(reader) != smtlib_string)
+        {
+            smtlib_error(reader, "expected a string");
+            return false;
+        }
+
+        fputc('"', reader->output);
+        for (size_t i = 0; i < reader->text_length; ++i)
+        {
+            if (reader->text[i] == '"') { fputc('"', reader->output); }
+            fputc(reader->text[i], reader->output);
+        }
+        fprintf(reader->output, "\"\n");
+        return smtlib_expect_close(reader);
+    }
+
+    if (smtlib_is(reader, "reset") || smtlib_is(reader, "reset-assertions"))
+    {
+        if (!smtlib_expect_close(reader)) { return false; }
+
+        smtlib_reset(reader);
+        return true;
+    }
+
+    if (smtlib_is(reader, "exit"))
+    {
+        reader->exit = true;
+        return smtlib_expect_close(reader);
+    }
+
+    fprintf(reader->output, "unsupported\n");
+    smtlib_skip_command(reader);
+    return true;
+}
+
+/*
+ * Frees the reader with its context.
+ */
+static void smtlib_reader_free(smtlib_reader* reader)
+{
+    context_free(reader->context);
+    free(reader->text);
+    free(reader->lets);
+    free(reader->definitions);
+    free(reader->declared);
+    free(reader->declarations);
+    free(reader->frames);
+    free(reader->values);
+    free(reader->pending);
+    free(reader->undo);
+    free(reader);
+}
+
+/*
+ * Runs an SMT-LIB 2 script over Boolean constants (QF_BOOL) from a file (or standard input when the path is NULL or
+ * "-"), answering each command on the output as it is read. The assertions are kept in one incremental solver
+ * context, so push, pop and check-sat-assuming reuse the work of earlier checks.
+ * Declarations and definitions are global: they are not removed by pop. Commands outside this subset are answered
+ * with unsupported. Returns the number of errors, or -1 if the input cannot be opened.
+ */
+int smtlib_run(const char* path, FILE* output)
+{
+    FILE* input = stdin;
+    if (path != NULL && strcmp(path, "-") != 0)
+    {
+        input = fopen(path, "r");
+        if (input == NULL)
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            return -1;
+        }
+    }
+
+    smtlib_reader* reader = (smtlib_reader*)calloc(1, sizeof(smtlib_reader));
+    reader->input = input;
+    reader->output = output;
+    reader->context = context_create();
+    reader->text_capacity = 64;
+    reader->text = (char*)malloc(reader->text_capacity);
+
+    while (!reader->exit)
+    {
+        smtlib_token type = smtlib_token_next(reader);
+        if (type == smtlib_eof) { break; }
+
+        if (type != smtlib_open)
+        {
+            smtlib_error(reader, "expected a command");
+            if (type == smtlib_invalid) { break; }
+            continue;
+        }
+
+        if (!smtlib_command(reader)) { smtlib_skip_command(reader); }
+        reader->depth = 0;
+        fflush(output);
+    }
+
+    int errors = reader->errors;
+    smtlib_reader_free(reader);
+    if (input != stdin) { fclose(input); }
+    return errors;
+}
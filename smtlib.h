@@ -0,0 +1,8 @@
+#ifndef THEOREMPROVER_SMTLIB_H
+#define THEOREMPROVER_SMTLIB_H
+
+#include <stdio.h>
+
+int smtlib_run(const char* path, FILE* output);
+
+#endif //THEOREMPROVER_SMTLIB_H
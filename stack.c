@@ -0,0 +1,52 @@
+#include "stack.h"
+
+#include <stdlib.h>
+
+/*
+ * Initializes an empty stack.
+ */
+void stack_init(stack* stack)
+{
+    stack->items = NULL;
+    stack->size = 0;
+    stack->capacity = 0;
+}
+
+/*
+ * Frees the items array of the stack (the stack itself is owned by the caller).
+ */
+void stack_destroy(stack* stack)
+{
+    free(stack->items);
+    stack_init(stack);
+}
+
+/*
+ * Pushes an item on top of the stack, doubling the capacity when the stack is full.
+ */
+void stack_push(stack* stack, void* item)
+{
+    if (stack->size == stack->capacity)
+    {
+        stack->capacity = stack->capacity == 0 ? 64 : 2 * stack->capacity;
+        stack->items = (void**)realloc(stack->items, stack->capacity * sizeof(void*));
+    }
+
+    stack->items[stack->size++] = item;
+}
+
+/*
+ * Pops the item from the top of the stack (NULL if the stack is empty).
+ */
+void* stack_pop(stack* stack)
+{
+    return stack->size > 0 ? stack->items[--stack->size] : NULL;
+}
+
+/*
+ * Checks if the stack is empty.
+ */
+bool stack_empty(stack* stack)
+{
+    return stack->size == 0;
+}
@@ -0,0 +1,28 @@
+#ifndef THEOREMPROVER_STACK_H
+#define THEOREMPROVER_STACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Stack is a growable array of pointers used as the explicit stack of the iterative tree traversals.
+ * The array is only allocated on the first push, so traversals that never branch do not allocate.
+ */
+typedef struct stack
+{
+    void** items;
+    size_t size;
+    size_t capacity;
+} stack;
+
+void stack_init(stack* stack);
+
+void stack_destroy(stack* stack);
+
+void stack_push(stack* stack, void* item);
+
+void* stack_pop(stack* stack);
+
+bool stack_empty(stack* stack);
+
+#endif //THEOREMPROVER_STACK_H
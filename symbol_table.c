@@ -0,0 +1,182 @@
+#include "symbol_table.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYMBOL_CHUNK_BASE 64 // entries of the first chunk, each further chunk has twice the entries of the one before.
+#define SYMBOL_CHUNKS 26     // enough chunks for every non-negative int id.
+
+/*
+ * Symbol entry is the name of an interned proposition and its length.
+ */
+typedef struct symbol_entry
+{
+    char* name;
+    size_t length;
+} symbol_entry;
+
+/*
+ * The symbol table interns proposition names and maps each distinct name to a dense integer id (0, 1, 2, ...).
+ * Names are stored in chunks indexed by id and looked up through an open addressing hash table of ids.
+ * The table is shared by every factory, so interning is locked for the queries that parse formulas on several threads.
+ * The chunks are never moved or freed and an entry is written before the count that covers it is published with a
+ * release store, so the lookups by id, which print formulas on every thread, read without the lock.
+ */
+typedef struct symbol_table
+{
+    pthread_mutex_t lock;
+    symbol_entry* chunks[SYMBOL_CHUNKS]; // chunk k holds the ids from SYMBOL_CHUNK_BASE * (2^k - 1) on.
+    int count;        // number of interned names (published atomically).
+    int* slots;       // hash table of ids (-1 marks an empty slot).
+    size_t slot_mask; // number of slots minus one (the number of slots is a power of two).
+} symbol_table;
+
+static symbol_table table = { PTHREAD_MUTEX_INITIALIZER, { NULL }, 0, NULL, 0 };
+
+/*
+ * Gets the chunk of an id: chunk k starts at id SYMBOL_CHUNK_BASE * (2^k - 1).
+ */
+static int symbol_chunk(int id)
+{
+    return 31 - __builtin_clz((unsigned int)id / SYMBOL_CHUNK_BASE + 1);
+}
+
+/*
+ * Gets the entry of an id, whose chunk must have been allocated.
+ */
+static symbol_entry* symbol_entry_of(int id)
+{
+    int chunk = symbol_chunk(id);
+    return &table.chunks[chunk][(unsigned int)id - SYMBOL_CHUNK_BASE * ((1u << chunk) - 1)];
+}
+
+/*
+ * FNV-1a hash of a name.
+ */
+static uint64_t symbol_hash(const char* name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Inserts an id into the hash table (the table must have a free slot).
+ */
+static void symbol_insert_slot(int id)
+{
+    const symbol_entry* entry = symbol_entry_of(id);
+    size_t slot = symbol_hash(entry->name, entry->length) & table.slot_mask;
+    while (table.slots[slot] != -1)
+    {
+        slot = (slot + 1) & table.slot_mask;
+    }
+    table.slots[slot] = id;
+}
+
+/*
+ * Doubles the number of hash table slots and reinserts every id.
+ */
+static void symbol_grow_slots()
+{
+    size_t slots = table.slots == NULL ? 64 : 2 * (table.slot_mask + 1);
+    free(table.slots);
+    table.slots = (int*)malloc(slots * sizeof(int));
+    memset(table.slots, -1, slots * sizeof(int));
+    table.slot_mask = slots - 1;
+
+    for (int id = 0; id < table.count; ++id)
+    {
+        symbol_insert_slot(id);
+    }
+}
+
+/*
+ * Returns the id of the proposition name, adding the name to the table if it has not been seen before (the table must
+ * be locked).
+ */
+static int symbol_find_or_add(const char* name, size_t length)
+{
+    if (table.slots == NULL)
+    {
+        symbol_grow_slots();
+    }
+
+    size_t slot = symbol_hash(name, length) & table.slot_mask;
+    while (table.slots[slot] != -1)
+    {
+        const symbol_entry* entry = symbol_entry_of(table.slots[slot]);
+        if (entry->length == length && memcmp(entry->name, name, length) == 0)
+        {
+            return table.slots[slot]; // name has already been interned.
+        }
+        slot = (slot + 1) & table.slot_mask;
+    }
+
+    int id = table.count;
+    int chunk = symbol_chunk(id);
+    if (table.chunks[chunk] == NULL)
+    {
+        table.chunks[chunk] = (symbol_entry*)malloc(((size_t)SYMBOL_CHUNK_BASE << chunk) * sizeof(symbol_entry));
+    }
+
+    symbol_entry* entry = symbol_entry_of(id);
+    entry->name = (char*)malloc(length + 1);
+    memcpy(entry->name, name, length);
+    entry->name[length] = '\0';
+    entry->length = length;
+    __atomic_store_n(&table.count, id + 1, __ATOMIC_RELEASE);
+
+    // Keep the load factor of the hash table at most one half.
+    if (2 * (size_t)table.count > table.slot_mask + 1)
+    {
+        symbol_grow_slots();
+    }
+    else
+    {
+        table.slots[slot] = id;
+    }
+
+    return id;
+}
+
+/*
+ * Returns the id of the proposition name, adding the name to the table if it has not been seen before.
+ */
+int symbol_intern(const char* name, size_t length)
+{
+    pthread_mutex_lock(&table.lock);
+    int id = symbol_find_or_add(name, length);
+    pthread_mutex_unlock(&table.lock);
+    return id;
+}
+
+/*
+ * Gets the name of the proposition with the given id.
+ */
+const char* symbol_name(int id)
+{
+    return id >= 0 && id < __atomic_load_n(&table.count, __ATOMIC_ACQUIRE) ? symbol_entry_of(id)->name : NULL;
+}
+
+/*
+ * Gets the length of the name of the proposition with the given id.
+ */
+size_t symbol_length(int id)
+{
+    return id >= 0 && id < __atomic_load_n(&table.count, __ATOMIC_ACQUIRE) ? symbol_entry_of(id)->length : 0;
+}
+
+/*
+ * Gets the number of distinct proposition names interned so far (ids range over 0 to count - 1).
+ */
+int symbol_count()
+{
+    return __atomic_load_n(&table.count, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,14 @@
+#ifndef THEOREMPROVER_SYMBOL_TABLE_H
+#define THEOREMPROVER_SYMBOL_TABLE_H
+
+#include <stddef.h>
+
+int symbol_intern(const char* name, size_t length);
+
+const char* symbol_name(int id);
+
+size_t symbol_length(int id);
+
+int symbol_count();
+
+#endif //THEOREMPROVER_SYMBOL_TABLE_H
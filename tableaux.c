@@ -1,40 +1,52 @@
 #include "tableaux.h"
 #include "tree.h"
+#include "arena.h"
+#include "nnf.h"
+#include "tokenizer.h"
 #include <stdlib.h>
+#include <string.h>
+
+static const size_t tableau_initial_slots = 64; // initial number of slots of the hash set of queued theories.
 
 /*
  * Creates an isolated tableau node initialized with a theory.
  */
-tableau_node* tableau_node_create(theory* theory)
+tableau_node* tableau_node_create(arena* arena, theory* theory)
 {
-    tableau_node* node = (tableau_node*)malloc(sizeof(tableau_node));
+    tableau_node* node = (tableau_node*)arena_alloc(arena, sizeof(tableau_node));
     node->theory = theory;
     node->next = NULL;
     return node;
 }
 
 /*
- * Frees the theory then the tableau node.
+ * Frees the theory then releases the tableau node to the arena.
  */
-void tableau_node_free(tableau_node* node)
+void tableau_node_free(arena* arena, tableau_node* node)
 {
     theory_free(node->theory);
-    free(node);
+    arena_release(arena, node, sizeof(tableau_node));
 }
 
 /*
- * Creates an empty tableau.
+ * Creates an empty tableau allocated from the arena.
  */
-tableau* tableau_create()
+tableau* tableau_create(arena* arena)
 {
-    tableau* tab = (tableau*)malloc(sizeof(tableau));
+    tableau* tab = (tableau*)arena_alloc(arena, sizeof(tableau));
     tab->front = NULL;
     tab->rear = NULL;
+    tab->arena = arena;
+    tab->slots = (tableau_slot*)arena_alloc(arena, tableau_initial_slots * sizeof(tableau_slot));
+    memset(tab->slots, 0, tableau_initial_slots * sizeof(tableau_slot));
+    tab->mask = tableau_initial_slots - 1;
+    tab->size = 0;
     return tab;
 }
 
 /*
  * Frees the tableau and all of the tableau nodes.
+ * A tableau does not need to be freed when the whole arena is about to be freed.
  */
 void tableau_free(tableau* tableau)
 {
@@ -44,22 +56,87 @@ void tableau_free(tableau* tableau)
         while (node != NULL)
         {
             tableau_node* next = node->next;
-            tableau_node_free(node);
+            tableau_node_free(tableau->arena, node);
             node = next;
         }
 
-        free(tableau);
+        arena_release(tableau->arena, tableau->slots, (tableau->mask + 1) * sizeof(tableau_slot));
+        arena_release(tableau->arena, tableau, sizeof(*tableau));
+    }
+}
+
+/*
+ * Inserts a theory into the hash set of queued theories (linear probing).
+ */
+static void tableau_index_insert(tableau* tableau, theory* theory)
+{
+    size_t i = (size_t)theory->fingerprint & tableau->mask;
+    while (tableau->slots[i].theory != NULL)
+    {
+        i = (i + 1) & tableau->mask;
     }
+
+    tableau->slots[i].fingerprint = theory->fingerprint;
+    tableau->slots[i].theory = theory;
+}
+
+/*
+ * Doubles the number of slots of the hash set of queued theories and reinserts the theories.
+ */
+static void tableau_index_grow(tableau* tableau)
+{
+    tableau_slot* slots = tableau->slots;
+    size_t count = tableau->mask + 1;
+
+    tableau->slots = (tableau_slot*)arena_alloc(tableau->arena, 2 * count * sizeof(tableau_slot));
+    memset(tableau->slots, 0, 2 * count * sizeof(tableau_slot));
+    tableau->mask = 2 * count - 1;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (slots[i].theory != NULL) { tableau_index_insert(tableau, slots[i].theory); }
+    }
+
+    arena_release(tableau->arena, slots, count * sizeof(tableau_slot));
+}
+
+/*
+ * Removes a queued theory from the hash set. The following slots of the probe sequence are shifted back into the
+ * emptied slot, so lookups never need tombstones.
+ */
+static void tableau_index_remove(tableau* tableau, theory* theory)
+{
+    size_t i = (size_t)theory->fingerprint & tableau->mask;
+    while (tableau->slots[i].theory != theory)
+    {
+        i = (i + 1) & tableau->mask;
+    }
+
+    for (size_t j = (i + 1) & tableau->mask; tableau->slots[j].theory != NULL; j = (j + 1) & tableau->mask)
+    {
+        // The slot j may move to the hole i only if its home slot is not cyclically in (i, j].
+        size_t home = (size_t)tableau->slots[j].fingerprint & tableau->mask;
+        if (((j - home) & tableau->mask) >= ((j - i) & tableau->mask))
+        {
+            tableau->slots[i] = tableau->slots[j];
+            i = j;
+        }
+    }
+
+    tableau->slots[i].theory = NULL;
+    --tableau->size;
 }
 
 /*
  * Checks if the tableau contains a theory.
+ * Only the queued theories with the same fingerprint are compared with the theory.
  */
 bool tableau_contains(tableau* tableau, theory* theory)
 {
-    for (tableau_node* node = tableau->front; node != NULL; node = node->next)
+    for (size_t i = (size_t)theory->fingerprint & tableau->mask; tableau->slots[i].theory != NULL;
+         i = (i + 1) & tableau->mask)
     {
-        if (theory_equals(theory, node->theory))
+        if (tableau->slots[i].fingerprint == theory->fingerprint && theory_equals(theory, tableau->slots[i].theory))
         {
             return true;
         }
@@ -70,10 +147,11 @@ bool tableau_contains(tableau* tableau, theory* theory)
 
 /*
  * Pushes theory to the end of the the tableau queue.
+ * The theory must not be changed while it is queued since it is indexed by its fingerprint.
  */
 void tableau_enqueue(tableau* tableau, theory* theory)
 {
-    tableau_node* node = tableau_node_create(theory);
+    tableau_node* node = tableau_node_create(tableau->arena, theory);
 
     if (tableau->rear != NULL)
     {
@@ -85,6 +163,11 @@ void tableau_enqueue(tableau* tableau, theory* theory)
     }
 
     tableau->rear = node;
+
+    // The hash set is kept at most half full.
+    if (2 * (tableau->size + 1) > tableau->mask + 1) { tableau_index_grow(tableau); }
+    tableau_index_insert(tableau, theory);
+    ++tableau->size;
 }
 
 /*
@@ -108,8 +191,8 @@ theory* tableau_dequeue(tableau* tableau)
     }
 
     theory* theory = node->theory;
-    node->theory = NULL;
-    tableau_node_free(node);
+    tableau_index_remove(tableau, theory);
+    arena_release(tableau->arena, node, sizeof(tableau_node));
     return theory;
 }
 
@@ -126,20 +209,22 @@ bool tableau_empty(tableau* tableau)
  */
 void tableau_init(tableau* tableau, tree_node* formula)
 {
-    theory* theory = theory_create();
+    theory* theory = theory_create(tableau->arena);
     theory_push(theory, formula);
     tableau_enqueue(tableau, theory);
 }
 
 /*
- * Tableau theorem prover algorithm tests whether a propositional formula is satisfiable or unsatisfiable.
+ * Runs the tableau algorithm on the tableau until a satisfiable branch is found, every branch closes or the budget
+ * runs out, expanding the formulas in the order of the selection policy and splitting beta formulas with the
+ * branching rule.
+ * The formulas of the theories are in negation normal form, so every non-literal is a conjunction (alpha rule) or a
+ * disjunction (beta rule) whose operands are added as they are, and expanding never creates formulas.
+ * All theories and tableau nodes are allocated from the proof arena.
  */
-bool tableau_algorithm(tree_node* formula)
+static prover_result tableau_search(tableau* tableau, selection* selection, const branching* branching,
+                                    budget* budget, bool* valuation, prover_stats* stats)
 {
-    // Create tableau and initialize tableau with root formula.
-    tableau* tableau = tableau_create();
-    tableau_init(tableau, formula);
-
     while (!tableau_empty(tableau))
     {
         theory* set = tableau_dequeue(tableau); // dequeue the next unexpanded root formula from the tableau.
@@ -147,37 +232,47 @@ bool tableau_algorithm(tree_node* formula)
         theory* set2 = NULL;
 
         if (theory_fully_expanded(set) && !theory_contradictory(set))
+        {
+            if (valuation != NULL) { theory_valuation(set, valuation); } // the open branch is a model.
+            return result_true; // original formula is satisfiable.
+        }
+
+        if (budget_exhausted(budget, stats->expansions, tableau->arena->live_bytes))
         {
             theory_free(set);
-            tableau_free(tableau);
-            return true; // original formula is satisfiable.
+            return result_unknown;
         }
 
-        tree_node* phi = theory_pick_non_literal(set);
-        tree_node* left = NULL;
-        tree_node* right = NULL;
-        formula_type type = get_formula_type(phi, &left, &right);
+        size_t position;
+        tree_node* phi = selection_pick(selection, set, &position);
+        ++stats->expansions;
 
-        // Expand formula based on type of non-literal (alpha rule for conjunction and beta rule for disjunction).
-        switch (type)
+        if (is_and_connective(phi->token.symbol))
         {
-            case alpha:
-                // The theory is enqueued with the alpha formula replaced by the left and right subformulas.
-                theory_push(set, left);
-                theory_push(set, right);
-                if (!theory_contradictory(set) && !tableau_contains(tableau, set))
-                {
-                    tableau_enqueue(tableau, set); // enqueue theory if not contradictory and not in the tableau.
-                }
-                else
-                {
-                    theory_free(set);
-                }
-                break;
-            case beta:
-                // The left subformula is enqueued as a separate theory.
-                set1 = theory_copy(set);
-                theory_push(set1, left);
+            // The theory is enqueued with the alpha formula replaced by the left and right subformulas.
+            theory_push(set, phi->left_child);
+            theory_push(set, phi->right_child);
+            if (!theory_contradictory(set) && !tableau_contains(tableau, set))
+            {
+                tableau_enqueue(tableau, set); // enqueue theory if not contradictory and not in the tableau.
+            }
+            else
+            {
+                theory_free(set);
+            }
+        }
+        else
+        {
+            branching_split split;
+            branching_expand(branching, set, phi, &split);
+            if (split.branches)
+            {
+                ++stats->branches;
+
+                // The left branch is enqueued as a separate theory (the copy shares the formulas of the theory).
+                set1 = theory_copy(tableau->arena, set);
+                theory_push(set1, split.left[0]);
+                theory_push(set1, split.left[1]);
                 if (!theory_contradictory(set1) && !tableau_contains(tableau, set1))
                 {
                     tableau_enqueue(tableau, set1); // enqueue theory if not contradictory and not in the tableau.
@@ -186,49 +281,262 @@ bool tableau_algorithm(tree_node* formula)
                 {
                     theory_free(set1);
                 }
+            }
+
+            // The right branch (or the only branch) is added to the theory itself, which is not needed any more.
+            set2 = set;
+            theory_push(set2, split.branches ? split.right[0] : split.left[0]);
+            theory_push(set2, split.branches ? split.right[1] : split.left[1]);
+            if (!theory_contradictory(set2) && !tableau_contains(tableau, set2))
+            {
+                tableau_enqueue(tableau, set2); // enqueue theory if not contradictory and not in the tableau.
+            }
+            else
+            {
+                theory_free(set2);
+            }
+        }
+    }
+
+    return result_false; // original formula is not satisfiable.
+}
+
+/*
+ * Trail step records a change of the theory of a depth-first search: a formula that was picked for expansion (with its
+ * position in the beta list, 0 for an alpha formula) or a formula that was pushed by an expansion.
+ */
+typedef struct tableau_step
+{
+    tree_node* formula;
+    bool picked;
+    size_t position;
+} tableau_step;
+
+/*
+ * Choice point records the beta formula expansion to resume on backtracking: the trail size after the beta formula
+ * was picked and the formulas of the right branch that has not been tried yet.
+ */
+typedef struct tableau_choice
+{
+    size_t trail_size;
+    tree_node* right[2];
+} tableau_choice;
+
+/*
+ * Makes room for one more item in an array allocated from the arena, doubling its capacity when it is full.
+ */
+static void* tableau_reserve(arena* arena, void* items, size_t size, size_t* capacity, size_t item_size)
+{
+    if (size < *capacity) { return items; }
+
+    size_t grown = *capacity > 0 ? 2 * *capacity : 64;
+    void* larger = arena_alloc(arena, grown * item_size);
+    if (items != NULL)
+    {
+        memcpy(larger, items, size * item_size);
+        arena_release(arena, items, *capacity * item_size);
+    }
+
+    *capacity = grown;
+    return larger;
+}
 
-                // The right subformula is enqueued as a separate theory.
-                set2 = theory_copy(set);
-                theory_push(set2, right);
-                if (!theory_contradictory(set2) && !tableau_contains(tableau, set2))
+/*
+ * Pushes a formula to the theory of a depth-first search and records it on the trail if it was added.
+ */
+static void tableau_trail_push(arena* arena, theory* set, tree_node* formula, tableau_step** trail, size_t* size,
+                               size_t* capacity)
+{
+    if (theory_push(set, formula))
+    {
+        *trail = (tableau_step*)tableau_reserve(arena, *trail, *size, capacity, sizeof(tableau_step));
+        (*trail)[(*size)++] = (tableau_step){ formula, false, 0 };
+    }
+}
+
+/*
+ * Checks if a subformula of a beta formula is a literal that is already in the theory.
+ */
+static inline bool tableau_satisfied_literal(theory* set, tree_node* formula)
+{
+    return is_literal(formula) && theory_contains(set, formula);
+}
+
+/*
+ * Runs the tableau algorithm depth-first on a single theory that is changed in place.
+ * Every change is recorded on a trail: an alpha formula is replaced by its subformulas and a beta formula by the
+ * formulas of the left branch of the branching rule, leaving a choice point. When the theory becomes contradictory the
+ * trail is undone back to the latest choice point and the formulas of its right branch are pushed instead, the way SAT
+ * solvers backtrack. Only the current branch is kept, so memory is linear in the size of the formula, and the first
+ * open branch is found without expanding the others. The formulas are expanded in the order of the selection policy.
+ * The right branch of a beta expansion is first offered to the spawn hook (if any), and no choice point is left for a
+ * branch the hook takes. The search stops with an unknown result as soon as the cancel flag (if any) is set or the
+ * budget (if any) runs out.
+ */
+prover_result tableau_depth_first(arena* proof, theory* set, selection* selection, const branching* branching,
+                                  tableau_spawn spawn, void* context, const bool* cancel, budget* budget,
+                                  prover_stats* stats)
+{
+    tableau_step* trail = NULL;
+    size_t trail_size = 0;
+    size_t trail_capacity = 0;
+    tableau_choice* choices = NULL;
+    size_t choice_count = 0;
+    size_t choice_capacity = 0;
+    prover_result result = result_unknown;
+
+    while (cancel == NULL || !__atomic_load_n(cancel, __ATOMIC_RELAXED))
+    {
+        if (theory_contradictory(set))
+        {
+            if (choice_count == 0)
+            {
+                result = result_false; // every branch is closed so the original formula is not satisfiable.
+                break;
+            }
+
+            // Backtrack to the latest choice point and take its right branch.
+            tableau_choice choice = choices[--choice_count];
+            while (trail_size > choice.trail_size)
+            {
+                tableau_step step = trail[--trail_size];
+                if (step.picked && step.position > 0)
                 {
-                    tableau_enqueue(tableau, set2); // enqueue theory if not contradictory and not in the tableau.
+                    theory_restore_beta(set, step.formula, step.position); // back to its place in the beta list.
+                }
+                else if (step.picked)
+                {
+                    theory_push(set, step.formula); // the formula goes back to the front of its list.
                 }
                 else
                 {
-                    theory_free(set2);
+                    theory_retract(set, step.formula);
                 }
+            }
 
-                theory_free(set);
-                break;
-            default:
-                exit(1);
+            tableau_trail_push(proof, set, choice.right[0], &trail, &trail_size, &trail_capacity);
+            tableau_trail_push(proof, set, choice.right[1], &trail, &trail_size, &trail_capacity);
+            continue;
+        }
+
+        if (theory_fully_expanded(set))
+        {
+            result = result_true; // original formula is satisfiable.
+            break;
         }
 
-        tree_free(phi);
+        if (budget != NULL && budget_exhausted(budget, stats->expansions, proof->live_bytes)) { break; }
+
+        size_t position;
+        tree_node* phi = selection_pick(selection, set, &position);
+        trail = (tableau_step*)tableau_reserve(proof, trail, trail_size, &trail_capacity, sizeof(tableau_step));
+        trail[trail_size++] = (tableau_step){ phi, true, position };
+        ++stats->expansions;
+
+        if (is_and_connective(phi->token.symbol))
+        {
+            tableau_trail_push(proof, set, phi->left_child, &trail, &trail_size, &trail_capacity);
+            tableau_trail_push(proof, set, phi->right_child, &trail, &trail_size, &trail_capacity);
+        }
+        else if (tableau_satisfied_literal(set, phi->left_child) || tableau_satisfied_literal(set, phi->right_child))
+        {
+            // The theory already contains a literal of the beta formula, so the theory without the beta formula is
+            // satisfiable if and only if the theory is, and both branches would only add to it.
+        }
+        else
+        {
+            branching_split split;
+            branching_expand(branching, set, phi, &split);
+            if (split.branches)
+            {
+                ++stats->branches;
+                if (spawn == NULL || !spawn(context, set, split.right[0], split.right[1]))
+                {
+                    choices = (tableau_choice*)tableau_reserve(proof, choices, choice_count, &choice_capacity,
+                                                               sizeof(tableau_choice));
+                    choices[choice_count++] = (tableau_choice){ trail_size, { split.right[0], split.right[1] } };
+                }
+            }
+
+            tableau_trail_push(proof, set, split.left[0], &trail, &trail_size, &trail_capacity);
+            tableau_trail_push(proof, set, split.left[1], &trail, &trail_size, &trail_capacity);
+        }
     }
 
-    tableau_free(tableau);
-    return false; // original formula is not satisfiable.
+    if (trail != NULL) { arena_release(proof, trail, trail_capacity * sizeof(tableau_step)); }
+    if (choices != NULL) { arena_release(proof, choices, choice_capacity * sizeof(tableau_choice)); }
+    return result;
 }
 
 /*
- * Tests whether a formula is satisfiable (true under at least one valuation).
+ * Runs the search on the root theory (allocated from the proof arena and in negation normal form, with its formulas in
+ * the factory) with the engine, limits, selection policy and branching rule of the options: breadth-first on a tableau
+ * of theories or depth-first on the root theory. Then releases every theory and tableau node of the proof in one step
+ * by freeing the arena.
+ * The statistics may be NULL.
  */
-bool is_satisfiable(tree_node* formula)
+static prover_result tableau_prove(arena* proof, formula_factory* factory, theory* root, const prover_options* options,
+                                   bool* valuation, prover_stats* stats)
 {
-    return tableau_algorithm(formula);
+    prover_stats local_stats;
+    if (stats == NULL) { stats = &local_stats; }
+    stats->expansions = 0;
+    stats->branches = 0;
+
+    budget budget;
+    budget_init(&budget, &options->limits, 1);
+
+    branching branching;
+    branching_init(&branching, options->branching, factory, root);
+
+    selection selection;
+    selection_init(&selection, options->selection, options->seed, factory, root);
+
+    prover_result result;
+    if (options->engine == engine_dfs)
+    {
+        result = tableau_depth_first(proof, root, &selection, &branching, NULL, NULL, NULL, &budget, stats);
+        if (result == result_true && valuation != NULL) { theory_valuation(root, valuation); } // the open branch.
+    }
+    else
+    {
+        tableau* tableau = tableau_create(proof);
+        tableau_enqueue(tableau, root);
+        result = tableau_search(tableau, &selection, &branching, &budget, valuation, stats);
+    }
+
+    selection_destroy(&selection);
+    branching_destroy(&branching);
+    stats->peak_bytes = proof->peak_bytes;
+    stats->total_bytes = proof->total_bytes;
+    arena_free(proof);
+    return result;
 }
 
 /*
- * Tests whether a formula is valid (true under all possible valuations).
+ * Tableau theorem prover algorithm tests whether a propositional formula (or its negation if negated is set) is
+ * satisfiable or unsatisfiable, searching depth-first for the dfs engine and breadth-first otherwise, within the limits
+ * of the options. The formula is converted into negation normal form first and new formulas are created in the factory.
+ * If the valuation is not NULL the propositions that are true on the open branch are set in it.
  */
-bool is_valid(tree_node* formula)
+prover_result tableau_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                const prover_options* options, bool* valuation, prover_stats* stats)
 {
-    token negated;
-    token_init(&negated, negation, '-');
-    tree_node* neg_formula = negated_formula(negated, formula);
+    arena* proof = arena_create();
+    theory* root = theory_create(proof);
+    theory_push(root, nnf_formula(factory, formula, negated));
+    return tableau_prove(proof, factory, root, options, valuation, stats);
+}
 
-    bool valid = !is_satisfiable(neg_formula); // ϕ is valid ⟺ -ϕ is unsatisfiable.
-    return valid;
-}
\ No newline at end of file
+/*
+ * Tableau theorem prover algorithm tests whether a theory (the conjunction of its formulas) is satisfiable, searching
+ * depth-first for the dfs engine and breadth-first otherwise, within the limits of the options. The theory is
+ * converted into a new theory in the proof arena and is left unchanged.
+ * If the valuation is not NULL the propositions that are true on the open branch are set in it.
+ */
+prover_result tableau_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                       bool* valuation, prover_stats* stats)
+{
+    arena* proof = arena_create();
+    return tableau_prove(proof, factory, nnf_theory(factory, proof, root), options, valuation, stats);
+}
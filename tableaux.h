@@ -1,7 +1,14 @@
 #ifndef THEOREMPROVER_TABLEAUX_H
 #define THEOREMPROVER_TABLEAUX_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "theory.h"
+#include "factory.h"
+#include "prover.h"
+#include "budget.h"
+#include "selection.h"
+#include "branching.h"
 
 /*
  * Tableau node contains a theory and a pointer to the next node in the tableau.
@@ -12,20 +19,42 @@ typedef struct tableau_node
     struct tableau_node* next;
 } tableau_node;
 
+/*
+ * Tableau slot indexes a queued theory by its fingerprint (an empty slot has no theory).
+ */
+typedef struct tableau_slot
+{
+    uint64_t fingerprint;
+    theory* theory;
+} tableau_slot;
+
 /*
  * Tableau is represented as a queue of theories.
+ * The queued theories are also kept in an open addressing hash set keyed by their fingerprints, so checking whether a
+ * theory is already in the tableau only compares it with the queued theories that have the same fingerprint.
  */
 typedef struct tableau
 {
     tableau_node* front;
     tableau_node* rear;
+    arena* arena; // the tableau, its nodes and its theories are allocated from the proof arena.
+    tableau_slot* slots;
+    size_t mask;  // number of slots minus one (the number of slots is a power of two).
+    size_t size;  // number of queued theories.
 } tableau;
 
-tableau_node* tableau_node_create(theory* theory);
+/*
+ * Tableau spawn hook is offered the right branch of each beta expansion of a depth-first search: the theory (with the
+ * beta formula already picked) and the formulas of the right branch (the second may be NULL). It returns true if it
+ * takes the branch, which is then searched elsewhere instead of being kept as a choice point.
+ */
+typedef bool (*tableau_spawn)(void* context, theory* set, tree_node* first, tree_node* second);
+
+tableau_node* tableau_node_create(arena* arena, theory* theory);
 
-void tableau_node_free(tableau_node* node);
+void tableau_node_free(arena* arena, tableau_node* node);
 
-tableau* tableau_create();
+tableau* tableau_create(arena* arena);
 
 void tableau_free(tableau* tableau);
 
@@ -39,10 +68,14 @@ bool tableau_empty(tableau* tableau);
 
 void tableau_init(tableau* tableau, tree_node* formula);
 
-bool tableau_algorithm(tree_node* formula);
+prover_result tableau_depth_first(arena* proof, theory* set, selection* selection, const branching* branching,
+                                  tableau_spawn spawn, void* context, const bool* cancel, budget* budget,
+                                  prover_stats* stats);
 
-bool is_satisfiable(tree_node* formula);
+prover_result tableau_algorithm(formula_factory* factory, tree_node* formula, bool negated,
+                                const prover_options* options, bool* valuation, prover_stats* stats);
 
-bool is_valid(tree_node* formula);
+prover_result tableau_theory_algorithm(formula_factory* factory, theory* root, const prover_options* options,
+                                       bool* valuation, prover_stats* stats);
 
 #endif //THEOREMPROVER_TABLEAUX_H
@@ -1,7 +1,10 @@
 #include "theory.h"
 #include "tree.h"
 #include "tokenizer.h"
+#include "arena.h"
+
 #include <stdlib.h>
+#include <string.h>
 
 /*
  * A literal is defined as a proposition (p) or a negated proposition (-p).
@@ -37,62 +40,252 @@ bool is_not_literal(tree_node* formula)
     return !is_literal(formula);
 }
 
+/*
+ * An alpha formula is a non-literal that expands into one theory: (A ^ B), -(A v B), -(A > B) or --A.
+ * Every other non-literal is a beta formula that expands into two theories.
+ */
+bool is_alpha(tree_node* formula)
+{
+    if (formula->token.type == negation)
+    {
+        tree_node* child = formula->left_child;
+        return child->token.type == negation || !is_and_connective(child->token.symbol);
+    }
+
+    return is_and_connective(formula->token.symbol);
+}
+
+/*
+ * Hashes a formula for the fingerprint of a theory. Formulas of a factory are unique, so the dense index of the node
+ * identifies the formula and is spread over 64 bits (with the splitmix64 finalizer) to make sums of hashes collide
+ * rarely.
+ */
+static inline uint64_t theory_formula_hash(tree_node* formula)
+{
+    uint64_t h = (uint64_t)formula->index + 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
 /*
  * Creates an isolated theory node initialized with a formula.
  */
-theory_node* theory_node_create(tree_node* formula)
+theory_node* theory_node_create(arena* arena, tree_node* formula)
 {
-    theory_node* node = (theory_node*)malloc(sizeof(theory_node));
+    theory_node* node = (theory_node*)arena_alloc(arena, sizeof(theory_node));
     node->formula = formula;
     node->next = NULL;
+    node->references = 1;
     return node;
 }
 
 /*
- * Frees the formula then the theory node.
+ * Releases the theory node to its arena (the formula is owned by its factory).
+ */
+void theory_node_free(arena* arena, theory_node* node)
+{
+    arena_release(arena, node, sizeof(theory_node));
+}
+
+/*
+ * Drops a reference to a list, releasing the nodes that are no longer referenced by any other list.
+ */
+static void theory_list_release(arena* arena, theory_node* node)
+{
+    while (node != NULL && --node->references == 0)
+    {
+        theory_node* next = node->next;
+        theory_node_free(arena, node);
+        node = next;
+    }
+}
+
+/*
+ * Removes the first node of a list and returns its formula. The node is only released if no other list shares it,
+ * otherwise the list just moves on to the next node.
  */
-void theory_node_free(theory_node* node)
+static tree_node* theory_list_pop(arena* arena, theory_node** list)
 {
-    tree_free(node->formula);
-    free(node);
+    theory_node* node = *list;
+    tree_node* formula = node->formula;
+    *list = node->next;
+
+    if (node->references == 1)
+    {
+        theory_node_free(arena, node); // the reference of the node to the next node passes to the list.
+    }
+    else
+    {
+        --node->references;
+        if (node->next != NULL) { ++node->next->references; }
+    }
+
+    return formula;
+}
+
+/*
+ * Adds a formula to the front of a list (the new node takes over the reference of the list to its old front).
+ */
+static void theory_list_push(arena* arena, theory_node** list, tree_node* formula)
+{
+    theory_node* node = theory_node_create(arena, formula);
+    node->next = *list;
+    *list = node;
+}
+
+/*
+ * Releases a reference to a literal set.
+ */
+static void theory_literal_set_release(arena* arena, theory_literal_set* literal_set)
+{
+    if (literal_set != NULL && --literal_set->references == 0)
+    {
+        arena_release(arena, literal_set, sizeof(theory_literal_set) + 2 * literal_set->words * sizeof(uint64_t));
+    }
 }
 
 /*
- * Creates an empty theory.
+ * Creates an empty theory allocated from the arena.
  */
-theory* theory_create()
+theory* theory_create(arena* arena)
 {
-    theory* set = (theory*)malloc(sizeof(theory));
-    set->front = NULL;
-    set->rear = NULL;
+    theory* set = (theory*)arena_alloc(arena, sizeof(theory));
+    set->alphas = NULL;
+    set->betas = NULL;
+    set->literals = NULL;
+    set->arena = arena;
+    set->literal_set = NULL;
+    set->non_literals = 0;
+    set->conflicts = 0;
+    set->fingerprint = 0;
     return set;
 }
 
 /*
- * Frees the theory and all of the theory nodes.
+ * Releases the theory and the theory nodes it does not share with other theories to the arena so later theories can
+ * reuse them. Theories do not need to be freed individually when the whole arena is about to be freed.
  */
 void theory_free(theory* theory)
 {
     if (theory != NULL)
     {
-        theory_node* node = theory->front;
-        while (node != NULL)
-        {
-            theory_node* next = node->next;
-            theory_node_free(node);
-            node = next;
-        }
+        theory_list_release(theory->arena, theory->alphas);
+        theory_list_release(theory->arena, theory->betas);
+        theory_list_release(theory->arena, theory->literals);
+        theory_literal_set_release(theory->arena, theory->literal_set);
+        arena_release(theory->arena, theory, sizeof(*theory));
+    }
+}
+
+/*
+ * Gets the first node of the theory for iterating over its formulas (alpha formulas, then beta formulas, then
+ * literals).
+ */
+theory_node* theory_first(theory* theory)
+{
+    if (theory->alphas != NULL) { return theory->alphas; }
+    return theory->betas != NULL ? theory->betas : theory->literals;
+}
 
-        free(theory);
+/*
+ * Gets the node after a node of the theory (NULL after the last formula).
+ */
+theory_node* theory_next(theory* theory, theory_node* node)
+{
+    if (node->next != NULL || is_literal(node->formula))
+    {
+        return node->next;
     }
+
+    // The end of the alpha formulas continues with the beta formulas and the end of those with the literals.
+    if (is_alpha(node->formula) && theory->betas != NULL) { return theory->betas; }
+    return theory->literals;
+}
+
+/*
+ * Gets the variable of a literal (the dense number of its proposition in the factory).
+ */
+static inline int theory_literal_id(tree_node* literal)
+{
+    return (int)(literal->token.type == proposition ? literal->variable : literal->left_child->variable);
+}
+
+/*
+ * Gets the position of the bit of a literal in the literal bitsets of a theory.
+ */
+static inline size_t theory_literal_bit(theory* theory, tree_node* literal)
+{
+    size_t id = (size_t)theory_literal_id(literal);
+    return literal->token.type == proposition ? id : 64 * theory->literal_set->words + id;
+}
+
+/*
+ * Gets the position of the bit of the complement of a literal.
+ */
+static inline size_t theory_complement_bit(theory* theory, tree_node* literal)
+{
+    size_t id = (size_t)theory_literal_id(literal);
+    return literal->token.type == proposition ? 64 * theory->literal_set->words + id : id;
 }
 
 /*
- * Checks if the theory contains a formula.
+ * Checks if a bit of the literal bitsets is set.
+ */
+static inline bool theory_test(theory* theory, size_t bit)
+{
+    return (theory->literal_set->bits[bit / 64] >> (bit % 64)) & 1u;
+}
+
+/*
+ * Checks if the literal bitsets of the theory cover the variable of a literal.
+ */
+static inline bool theory_covers(theory* theory, tree_node* literal)
+{
+    return theory->literal_set != NULL && (size_t)theory_literal_id(literal) < 64 * theory->literal_set->words;
+}
+
+/*
+ * Makes the literal set of the theory private (copying it if it is shared with another theory) and large enough for
+ * the variable of a literal. Variables are numbered densely in the factory of the query, so the sets are sized by the
+ * propositions of the query rather than by every name interned so far, and a set that grows doubles.
+ */
+static void theory_reserve(theory* theory, tree_node* literal)
+{
+    theory_literal_set* shared = theory->literal_set;
+    if (theory_covers(theory, literal) && shared->references == 1) { return; }
+
+    size_t words = ((size_t)theory_literal_id(literal) + 64) / 64;
+    if (shared != NULL && !theory_covers(theory, literal) && 2 * shared->words > words) { words = 2 * shared->words; }
+    if (shared != NULL && shared->words > words) { words = shared->words; }
+
+    size_t bytes = sizeof(theory_literal_set) + 2 * words * sizeof(uint64_t);
+    theory_literal_set* literal_set = (theory_literal_set*)arena_alloc(theory->arena, bytes);
+    memset(literal_set, 0, bytes);
+    literal_set->references = 1;
+    literal_set->words = words;
+
+    if (shared != NULL)
+    {
+        memcpy(literal_set->bits, shared->bits, shared->words * sizeof(uint64_t));
+        memcpy(literal_set->bits + words, shared->bits + shared->words, shared->words * sizeof(uint64_t));
+        theory_literal_set_release(theory->arena, shared);
+    }
+
+    theory->literal_set = literal_set;
+}
+
+/*
+ * Checks if the theory contains a formula (in constant time for literals).
  */
 bool theory_contains(theory* theory, tree_node* formula)
 {
-    for (theory_node* node = theory->front; node != NULL; node = node->next)
+    if (is_literal(formula))
+    {
+        return theory_covers(theory, formula) && theory_test(theory, theory_literal_bit(theory, formula));
+    }
+
+    for (theory_node* node = is_alpha(formula) ? theory->alphas : theory->betas; node != NULL; node = node->next)
     {
         if (tree_equals(formula, node->formula))
         {
@@ -103,16 +296,46 @@ bool theory_contains(theory* theory, tree_node* formula)
     return false;
 }
 
+/*
+ * Checks if two theories have the same literals by comparing their literal bitsets.
+ */
+static bool theory_same_literals(theory* set1, theory* set2)
+{
+    size_t words1 = set1->literal_set != NULL ? set1->literal_set->words : 0;
+    size_t words2 = set2->literal_set != NULL ? set2->literal_set->words : 0;
+
+    size_t words = words1 > words2 ? words1 : words2;
+
+    // Compares the positive (side 0) and negative (side 1) bitsets, a word beyond the size of a bitset being 0.
+    for (size_t side = 0; side < 2; ++side)
+    {
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t bits1 = word < words1 ? set1->literal_set->bits[side * words1 + word] : 0;
+            uint64_t bits2 = word < words2 ? set2->literal_set->bits[side * words2 + word] : 0;
+            if (bits1 != bits2) { return false; }
+        }
+    }
+
+    return true;
+}
+
 /*
  * Checks if two theories (sets of formulas) are equal.
+ * The literals are compared through their bitsets, so only the non-literals are compared one by one.
  */
 bool theory_equals(theory* set1, theory* set2)
 {
+    if (set1->literal_set != set2->literal_set && !theory_same_literals(set1, set2))
+    {
+        return false;
+    }
+
     // Set equality is defined as: A = B ⟺ (A ⊆ B) and (B ⊆ A).
     theory_node* node;
 
     // A is a subset of B (A ⊆ B).
-    for (node = set1->front; node != NULL; node = node->next)
+    for (node = theory_first(set1); node != NULL && is_not_literal(node->formula); node = theory_next(set1, node))
     {
         // A is a subset of B iff every element of A is also an element of B.
         if (!theory_contains(set2, node->formula))
@@ -122,7 +345,7 @@ bool theory_equals(theory* set1, theory* set2)
     }
 
     // B is a subset of A (B ⊆ A).
-    for (node = set2->front; node != NULL; node = node->next)
+    for (node = theory_first(set2); node != NULL && is_not_literal(node->formula); node = theory_next(set2, node))
     {
         // B is a subset of A iff every element of B is also an element of A.
         if (!theory_contains(set1, node->formula))
@@ -135,91 +358,191 @@ bool theory_equals(theory* set1, theory* set2)
 }
 
 /*
- * Pushes formula to the end of the theory.
+ * Pushes formula to the theory and returns false if the formula was not added.
+ * A literal that is already in the theory is not added again, and a literal whose complement is in the theory makes
+ * the theory contradictory.
  */
-void theory_push(theory* theory, tree_node* formula)
+bool theory_push(theory* theory, tree_node* formula)
 {
     if (formula != NULL)
     {
-        theory_node* node = theory_node_create(formula);
-
-        if (theory->rear != NULL)
+        if (is_literal(formula))
         {
-            theory->rear->next = node;
+            if (theory_contains(theory, formula)) { return false; }
+
+            theory_reserve(theory, formula);
+            size_t bit = theory_literal_bit(theory, formula);
+            theory->literal_set->bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+            if (theory_test(theory, theory_complement_bit(theory, formula))) { ++theory->conflicts; }
+            theory_list_push(theory->arena, &theory->literals, formula);
         }
         else
         {
-            theory->front = node;
+            ++theory->non_literals;
+            theory_list_push(theory->arena, is_alpha(formula) ? &theory->alphas : &theory->betas, formula);
         }
 
-        theory->rear = node;
+        theory->fingerprint += theory_formula_hash(formula);
+        return true;
     }
+
+    return false;
+}
+
+/*
+ * Removes the most recently pushed literal from the theory and returns it.
+ */
+static tree_node* theory_pop_literal(theory* theory)
+{
+    tree_node* formula = theory_list_pop(theory->arena, &theory->literals);
+    theory_reserve(theory, formula);
+    size_t bit = theory_literal_bit(theory, formula);
+    theory->literal_set->bits[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+    if (theory_test(theory, theory_complement_bit(theory, formula))) { --theory->conflicts; }
+    theory->fingerprint -= theory_formula_hash(formula);
+    return formula;
 }
 
 /*
- * Pops formula from the front of the theory.
+ * Pops the next non-literal to expand from the theory, or the most recently pushed literal if the theory is fully
+ * expanded.
  */
 tree_node* theory_pop(theory* theory)
 {
-    theory_node* node = theory->front;
+    if (theory->non_literals > 0)
+    {
+        return theory_pick_non_literal(theory);
+    }
 
-    if (node == NULL)
+    if (theory->literals == NULL)
     {
         return NULL; // theory is empty.
     }
 
-    theory->front = node->next;
-    node->next = NULL;
+    return theory_pop_literal(theory);
+}
 
-    if (theory->front == NULL)
+/*
+ * Undoes a push that added the formula to the theory, which must be the most recently added formula of its kind
+ * (literal, alpha or beta formula). Used to backtrack a theory that is changed in place.
+ */
+void theory_retract(theory* theory, tree_node* formula)
+{
+    if (is_literal(formula))
     {
-        theory->rear = NULL;
+        theory_pop_literal(theory);
+        return;
     }
 
-    tree_node* formula = node->formula;
-    node->formula = NULL;
-    theory_node_free(node);
-    return formula;
+    theory_list_pop(theory->arena, is_alpha(formula) ? &theory->alphas : &theory->betas);
+    --theory->non_literals;
+    theory->fingerprint -= theory_formula_hash(formula);
 }
 
 /*
- * Pops the first non-literal formula form the theory and moves any literals to the back of the theory.
+ * Removes the next non-literal formula to expand from the theory and returns it (NULL if the theory only contains
+ * literals): the most recently pushed alpha formula, or the most recently pushed beta formula if there is none.
+ * Takes constant time without allocating, and the nodes shared with other theories are left in place.
  */
 tree_node* theory_pick_non_literal(theory* theory)
 {
-    tree_node* last = theory->rear->formula;
-    if (last == NULL) { return NULL; } // theory is empty.
-    tree_node* formula = NULL;
+    if (theory->non_literals == 0) { return NULL; }
 
-    do
+    tree_node* formula = theory_list_pop(theory->arena, theory->alphas != NULL ? &theory->alphas : &theory->betas);
+    --theory->non_literals;
+    theory->fingerprint -= theory_formula_hash(formula);
+    return formula;
+}
+
+/*
+ * Swaps the formulas at the front and at a position of a list. The nodes are changed in place when the list owns every
+ * node up to the position; otherwise those formulas are popped and pushed back swapped, which gives the list its own
+ * copy of the shared prefix (so following swaps are in place) and leaves the shared nodes to the other lists.
+ */
+static void theory_list_swap_front(arena* arena, theory_node** list, size_t position)
+{
+    if (position == 0) { return; }
+
+    theory_node* node = *list;
+    bool owned = node->references == 1;
+    for (size_t i = 0; i < position; ++i)
     {
-        formula = theory_pop(theory);
+        node = node->next;
+        owned = owned && node->references == 1;
+    }
 
-        if (is_not_literal(formula))
-        {
-            return formula;
-        }
+    if (owned)
+    {
+        tree_node* front = (*list)->formula;
+        (*list)->formula = node->formula;
+        node->formula = front;
+        return;
+    }
 
-        theory_push(theory, formula);
+    size_t count = position + 1;
+    tree_node** prefix = (tree_node**)arena_alloc(arena, count * sizeof(tree_node*));
+    for (size_t i = 0; i < count; ++i) { prefix[i] = theory_list_pop(arena, list); }
+    tree_node* front = prefix[0];
+    prefix[0] = prefix[position];
+    prefix[position] = front;
+    for (size_t i = count; i-- > 0;) { theory_list_push(arena, list, prefix[i]); }
+    arena_release(arena, prefix, count * sizeof(tree_node*));
+}
 
-    } while (formula != last);
+/*
+ * Removes the beta formula at a position of the beta list (0 for the most recently pushed) and returns it. Since a
+ * theory is a set, the front formula takes its place, so this takes time linear in the position without allocating
+ * (unless the nodes up to the position are shared with a copy of the theory, see theory_list_swap_front).
+ */
+tree_node* theory_pick_beta(theory* theory, size_t position)
+{
+    theory_list_swap_front(theory->arena, &theory->betas, position);
+    return theory_pick_non_literal(theory); // the theory has no alpha formulas.
+}
+
+/*
+ * Undoes theory_pick_beta, putting the beta formula back at its position and the front formula back at the front.
+ */
+void theory_restore_beta(theory* theory, tree_node* formula, size_t position)
+{
+    theory_list_push(theory->arena, &theory->betas, formula);
+    theory_list_swap_front(theory->arena, &theory->betas, position);
 
-    return NULL; // theory contains only literals.
+    ++theory->non_literals;
+    theory->fingerprint += theory_formula_hash(formula);
 }
 
 /*
- * Creates a copy of the theory and all the formulas inside the theory.
+ * Creates a copy of the theory allocated from the arena. The formulas are shared with the original theory.
+ * A copy in the arena of the theory shares the lists and the literal set of the theory and takes constant time;
+ * a copy in another arena copies them.
  */
-theory* theory_copy(theory* set)
+theory* theory_copy(arena* arena, theory* set)
 {
-    theory* theory_copy = theory_create();
+    theory* theory_copy = theory_create(arena);
 
-    for (theory_node* node = set->front; node != NULL; node = node->next)
+    if (arena != set->arena)
     {
-        tree_node* formula_copy = tree_node_copy(node->formula);
-        theory_push(theory_copy, formula_copy);
+        for (theory_node* node = theory_first(set); node != NULL; node = theory_next(set, node))
+        {
+            theory_push(theory_copy, node->formula);
+        }
+
+        return theory_copy;
     }
 
+    theory_copy->alphas = set->alphas;
+    theory_copy->betas = set->betas;
+    theory_copy->literals = set->literals;
+    theory_copy->literal_set = set->literal_set;
+    if (set->alphas != NULL) { ++set->alphas->references; }
+    if (set->betas != NULL) { ++set->betas->references; }
+    if (set->literals != NULL) { ++set->literals->references; }
+    if (set->literal_set != NULL) { ++set->literal_set->references; }
+
+    theory_copy->non_literals = set->non_literals;
+    theory_copy->conflicts = set->conflicts;
+    theory_copy->fingerprint = set->fingerprint;
     return theory_copy;
 }
 
@@ -228,38 +551,47 @@ theory* theory_copy(theory* set)
  */
 bool theory_fully_expanded(theory* theory)
 {
-    for (theory_node* node = theory->front; node != NULL; node = node->next)
-    {
-        if (is_not_literal(node->formula))
-        {
-            return false;
-        }
-    }
-
-    return true;
+    return theory->non_literals == 0;
 }
 
 /*
- * Checks if theory is contradictory (if it contains a formula and its negation).
+ * Checks if theory is contradictory (if it contains a proposition and its negation).
+ * Only literals are compared: a complex formula and its negation always expand into complementary literals, so the
+ * branch still closes. Complementary literals are counted as they are pushed, so the check takes constant time.
  */
 bool theory_contradictory(theory* theory)
 {
-    for (theory_node* node1 = theory->front; node1 != NULL; node1 = node1->next)
+    return theory->conflicts > 0;
+}
+
+/*
+ * Sets the propositions that occur positively among the literals of the theory to true in a valuation indexed by
+ * proposition id (the other values are left unchanged). A fully expanded theory that is not contradictory is
+ * satisfied by the valuation that also makes every other proposition false.
+ */
+void theory_valuation(theory* theory, bool* valuation)
+{
+    for (theory_node* node = theory->literals; node != NULL; node = node->next)
     {
-        for (theory_node* node2 = theory->front; node2 != NULL; node2 = node2->next)
-        {
-            tree_node* formula2 = node2->formula;
-            char c = formula2->token.symbol;
+        if (node->formula->token.type == proposition) { valuation[node->formula->token.id] = true; }
+    }
+}
 
-            if (is_negation(c))
-            {
-                if (tree_equals(node1->formula, formula2->left_child))
-                {
-                    return true;
-                }
-            }
-        }
+/*
+ * Collects the formulas of the theory and all of their subformulas into a new array indexed by node index, with a
+ * NULL entry for every other node of the factory (count is the number of nodes of the factory). The array must be
+ * freed by the caller.
+ */
+tree_node** theory_subformulas(theory* theory, size_t count)
+{
+    tree_node** nodes = (tree_node**)calloc(count, sizeof(tree_node*));
+    tree_node** stack = (tree_node**)malloc((count + 1) * sizeof(tree_node*));
+
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node))
+    {
+        tree_subformulas(node->formula, nodes, stack);
     }
 
-    return false;
-}
\ No newline at end of file
+    free(stack);
+    return nodes;
+}
@@ -2,53 +2,101 @@
 #define THEOREMPROVER_THEORY_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef struct tree_node tree_node;
+typedef struct arena arena;
 
 /*
- * Theory node contains a formula and a pointer to the next node in the theory.
+ * Theory node contains a formula and a pointer to the next node of its list. Lists are persistent: nodes are never
+ * modified once linked, so a node can be shared by the lists of several theories and counts the references to it
+ * (from theories and from other nodes).
  */
 typedef struct theory_node
 {
     tree_node* formula;
     struct theory_node* next;
+    size_t references;
 } theory_node;
 
+/*
+ * Theory literal set holds the bitsets of the propositions (words [0, words)) and negated propositions
+ * ([words, 2 words)) of a theory. The set is shared by copies of a theory until one of them changes its literals.
+ */
+typedef struct theory_literal_set
+{
+    size_t references;
+    size_t words; // number of 64 bit words in each bitset.
+    uint64_t bits[];
+} theory_literal_set;
+
 /*
  * Theory is represented as a set of propositional formulas.
+ * Literals are kept in a literal store (a list and bitsets keyed by variable) and non-literals in a worklist
+ * made of two stacks, alpha formulas and beta formulas, so the next formula to expand is picked in constant time with
+ * alpha formulas (which do not branch) before beta formulas.
+ * The lists are persistent (most recently pushed first), so copying a theory shares the lists and its literal set and
+ * takes constant time and memory. A copy only allocates the nodes of the formulas pushed to it, and its own literal
+ * set when it first adds a literal.
+ * The literal bitsets make sure a literal is only added once and detect a contradiction in constant time when the
+ * complement of a literal of the theory is pushed. The fingerprint is updated as formulas are pushed and popped, so
+ * theories that are equal (with the same number of copies of each non-literal) have equal fingerprints.
  */
 typedef struct theory
 {
-    theory_node* front;
-    theory_node* rear;
+    theory_node* alphas;          // alpha formulas: (A ^ B), -(A v B), -(A > B) and --A.
+    theory_node* betas;           // beta formulas: (A v B), (A > B) and -(A ^ B).
+    theory_node* literals;        // literals.
+    arena* arena;                 // the theory, its nodes and its literal set are allocated from the arena.
+    theory_literal_set* literal_set;
+    size_t non_literals;          // number of formulas of the theory that are not literals.
+    size_t conflicts;             // number of propositions that occur in the theory both positively and negatively.
+    uint64_t fingerprint;         // order independent hash of the formulas (the sum of the hashes of their nodes).
 } theory;
 
 bool is_literal(tree_node* formula);
 
 bool is_not_literal(tree_node* formula);
 
-theory_node* theory_node_create(tree_node* formula);
+bool is_alpha(tree_node* formula);
+
+theory_node* theory_node_create(arena* arena, tree_node* formula);
 
-void theory_node_free(theory_node* node);
+void theory_node_free(arena* arena, theory_node* node);
 
-theory* theory_create();
+theory* theory_create(arena* arena);
 
 void theory_free(theory* theory);
 
+theory_node* theory_first(theory* theory);
+
+theory_node* theory_next(theory* theory, theory_node* node);
+
 bool theory_contains(theory* theory, tree_node* formula);
 
 bool theory_equals(theory* set1, theory* set2);
 
-void theory_push(theory* theory, tree_node* formula);
+bool theory_push(theory* theory, tree_node* formula);
 
 tree_node* theory_pop(theory* theory);
 
+void theory_retract(theory* theory, tree_node* formula);
+
 tree_node* theory_pick_non_literal(theory* theory);
 
-theory* theory_copy(theory* set);
+tree_node* theory_pick_beta(theory* theory, size_t position);
+
+void theory_restore_beta(theory* theory, tree_node* formula, size_t position);
+
+theory* theory_copy(arena* arena, theory* set);
 
 bool theory_fully_expanded(theory* theory);
 
 bool theory_contradictory(theory* theory);
 
+void theory_valuation(theory* theory, bool* valuation);
+
+tree_node** theory_subformulas(theory* theory, size_t count);
+
 #endif //THEOREMPROVER_THEORY_H
\ No newline at end of file
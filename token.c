@@ -16,6 +16,17 @@ void token_init(token* token, token_type type, char symbol)
 {
     token->type = type;
     token->symbol = symbol;
+    token->id = -1;
+}
+
+/*
+ * Initializes a proposition token with the interned id of the proposition name.
+ */
+void token_init_proposition(token* token, int id)
+{
+    token->type = proposition;
+    token->symbol = '\0';
+    token->id = id;
 }
 
 /*
@@ -27,11 +38,12 @@ void token_free(token* token)
 }
 
 /*
- * Checks whether two tokens are equal (have the same type and the same symbol).
+ * Checks whether two tokens are equal (have the same type, the same symbol and the same proposition id).
  */
 bool equals(token token1, token token2)
 {
     bool b1 = token1.type == token2.type;
     bool b2 = token1.symbol == token2.symbol;
-    return b1 && b2;
+    bool b3 = token1.id == token2.id;
+    return b1 && b2 && b3;
 }
\ No newline at end of file
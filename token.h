@@ -17,18 +17,21 @@ typedef enum token_type
 } token_type;
 
 /*
- * A token has a type and a symbol.
+ * A token has a type and a symbol. Proposition tokens carry the interned id of the proposition name instead.
  */
 typedef struct token
 {
     token_type type;
     char symbol;
+    int id;
 } token;
 
 token* token_alloc();
 
 void token_init(token* token, token_type type, char symbol);
 
+void token_init_proposition(token* token, int id);
+
 void token_free(token* token);
 
 bool equals(token token1, token token2);
@@ -1,10 +1,11 @@
 #include "tokenizer.h"
 #include "token.h"
+#include "symbol_table.h"
 
 /*
  * Skips over any whitespace characters in the input formula.
  */
-void read_whitespace(const char* formula, int* offset)
+void read_whitespace(const char* formula, size_t* offset)
 {
     while (is_whitespace(formula[*offset])) { ++(*offset); }
 }
@@ -12,15 +13,16 @@ void read_whitespace(const char* formula, int* offset)
 /*
  * Reads the next symbol in the input formula.
  */
-void read_symbol(const char* formula, int* offset, token* token)
+void read_symbol(const char* formula, size_t* offset, token* token)
 {
     char c = formula[*offset];
 
     if (is_proposition(c))
     {
-        // Creates a token for the propositional letter and increments the offset.
-        token_init(token, proposition, c);
-        ++(*offset);
+        // Creates a token for the interned proposition name and moves the offset past the name.
+        size_t start = *offset;
+        do { ++(*offset); } while (is_proposition_part(formula[*offset]));
+        token_init_proposition(token, symbol_intern(formula + start, *offset - start));
         return;
     }
 
@@ -62,7 +64,7 @@ void read_symbol(const char* formula, int* offset, token* token)
 /*
  * Reads any whitespace characters and the next symbol in the input formula.
  */
-void get_token(const char* formula, int* offset, token* token)
+void get_token(const char* formula, size_t* offset, token* token)
 {
     read_whitespace(formula, offset);
     read_symbol(formula, offset, token);
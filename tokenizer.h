@@ -2,6 +2,7 @@
 #define THEOREMPROVER_TOKENIZER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct token token;
 
@@ -14,11 +15,20 @@ static inline bool is_whitespace(char c)
 }
 
 /*
- * Checks if the character is a propositional letter.
+ * Checks if the character can start a proposition name (a letter or an underscore other than the connective v).
  */
 static inline bool is_proposition(char c)
 {
-    return c == 'p' || c == 'q' || c == 'r' || c == 'x' || c == 'y' || c == 'w'; // prop ::= p | q | r | x | y | w
+    bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    return letter && c != 'v'; // prop ::= [A-Za-z_][A-Za-z0-9_]* without the letter v.
+}
+
+/*
+ * Checks if the character can continue a proposition name (a letter, digit or underscore other than the connective v).
+ */
+static inline bool is_proposition_part(char c)
+{
+    return is_proposition(c) || (c >= '0' && c <= '9');
 }
 
 /*
@@ -85,10 +95,10 @@ static inline bool is_end(char c)
     return c == '\0';
 }
 
-void read_whitespace(const char* formula, int* offset);
+void read_whitespace(const char* formula, size_t* offset);
 
-void read_symbol(const char* formula, int* offset, token* token);
+void read_symbol(const char* formula, size_t* offset, token* token);
 
-void get_token(const char* formula, int* offset, token* token);
+void get_token(const char* formula, size_t* offset, token* token);
 
 #endif //THEOREMPROVER_TOKENIZER_H
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "token.h"
+#include "factory.h"
 
 /*
  * Alpha formulas are those that simplify (in one step) to a conjunction of two subformulas or are double negations.
@@ -16,28 +17,27 @@ typedef enum formula_type
 
 /*
  * Binary tree node contains a token and a pointer to the root nodes of the left and right subtrees.
+ * Nodes are created and owned by a formula factory which shares identical subformulas, so nodes are never modified
+ * or freed individually.
  */
 typedef struct tree_node
 {
     token token;
+    unsigned int variable;  // dense number of a proposition in its factory (0 for the other nodes).
     struct tree_node* left_child;
     struct tree_node* right_child;
+    unsigned int hash;      // structural hash of the formula.
+    unsigned int index;     // dense index of the node in its factory (in creation order).
 } tree_node;
 
-tree_node* tree_node_create(token token);
-
-void tree_free(tree_node* node);
-
 bool tree_equals(tree_node* node1, tree_node* node2);
 
-tree_node* tree_node_copy(tree_node* node);
-
-tree_node* negated_formula(token negation, tree_node* formula);
+tree_node* negated_formula(formula_factory* factory, token negation, tree_node* formula);
 
-tree_node* proposition_formula(token proposition);
+tree_node* proposition_formula(formula_factory* factory, token proposition);
 
-tree_node* binary_formula(token binary, tree_node* left_formula, tree_node* right_formula);
+tree_node* binary_formula(formula_factory* factory, token binary, tree_node* left_formula, tree_node* right_formula);
 
-formula_type get_formula_type(tree_node* formula, tree_node** exp1, tree_node** exp2);
+void tree_subformulas(tree_node* formula, tree_node** nodes, tree_node** stack);
 
 #endif //THEOREMPROVER_TREE_H
@@ -0,0 +1,278 @@
+#include "truth_table.h"
+#include "tree.h"
+#include "tokenizer.h"
+
+#include <stdlib.h>
+
+#define TRUTH_TABLE_BLOCK_BITS 8    // a block holds 2^8 = 64 * TRUTH_TABLE_LANES valuations.
+
+// values of the first six variables in a word: bit k of the word is the valuation k, where variable v is bit v of k.
+static const uint64_t truth_table_patterns[6] = {
+    0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+    0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL
+};
+
+/*
+ * Compiles the conjunction of formulas into the program of the truth table. The subformulas are numbered in node
+ * index order, which lists the operands of a formula before the formula, and a subformula shared by several formulas
+ * gets one register.
+ */
+static void truth_table_build(truth_table* table, formula_factory* factory, tree_node** formulas, size_t count)
+{
+    size_t capacity = factory->size;
+    tree_node** nodes = (tree_node**)calloc(capacity, sizeof(tree_node*));
+    tree_node** stack = (tree_node**)malloc((capacity + 1) * sizeof(tree_node*));
+    for (size_t i = 0; i < count; ++i) { tree_subformulas(formulas[i], nodes, stack); }
+    free(stack);
+
+    size_t variables = 0;
+    size_t size = count > 1 ? count - 1 : 1 - count; // the conjunctions of the formulas, or the constant of none.
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (nodes[i] == NULL) { continue; }
+
+        if (nodes[i]->token.type == proposition) { ++variables; }
+        else { ++size; }
+    }
+
+    table->instructions = (truth_table_instruction*)malloc(size * sizeof(truth_table_instruction));
+    table->propositions = (int*)malloc((variables + 1) * sizeof(int));
+    table->size = 0;
+    table->variables = 0;
+    table->negated = false;
+
+    uint32_t* registers = (uint32_t*)malloc((capacity + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (nodes[i] != NULL && nodes[i]->token.type == proposition)
+        {
+            registers[i] = (uint32_t)table->variables;
+            table->propositions[table->variables++] = nodes[i]->token.id;
+        }
+    }
+
+    table->registers = table->variables;
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        tree_node* node = nodes[i];
+        if (node == NULL || node->token.type == proposition) { continue; }
+
+        truth_table_instruction* instruction = &table->instructions[table->size++];
+        instruction->target = registers[i] = (uint32_t)table->registers++;
+        instruction->left = registers[node->left_child->index];
+        if (node->token.type == negation)
+        {
+            instruction->opcode = table_not;
+            instruction->right = instruction->left;
+        }
+        else
+        {
+            char symbol = node->token.symbol;
+            instruction->opcode = is_and_connective(symbol) ? table_and : (is_or_connective(symbol) ? table_or
+                                                                                                       : table_implies);
+            instruction->right = registers[node->right_child->index];
+        }
+    }
+
+    if (count == 0)
+    {
+        truth_table_instruction* instruction = &table->instructions[table->size++];
+        instruction->opcode = table_true;
+        instruction->target = instruction->left = instruction->right = (uint32_t)table->registers++;
+        table->result = instruction->target;
+    }
+    else
+    {
+        table->result = registers[formulas[0]->index];
+        for (size_t i = 1; i < count; ++i)
+        {
+            truth_table_instruction* instruction = &table->instructions[table->size++];
+            instruction->opcode = table_and;
+            instruction->left = table->result;
+            instruction->right = registers[formulas[i]->index];
+            instruction->target = table->result = (uint32_t)table->registers++;
+        }
+    }
+
+    free(registers);
+    free(nodes);
+}
+
+/*
+ * Compiles a formula (or its negation if negated is set) into a truth table.
+ */
+void truth_table_compile(truth_table* table, formula_factory* factory, tree_node* formula, bool negated)
+{
+    truth_table_build(table, factory, &formula, 1);
+    table->negated = negated;
+}
+
+/*
+ * Compiles a theory (the conjunction of its formulas) into a truth table.
+ */
+void truth_table_compile_theory(truth_table* table, formula_factory* factory, theory* theory)
+{
+    size_t count = 0;
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node)) { ++count; }
+
+    tree_node** formulas = (tree_node**)malloc((count + 1) * sizeof(tree_node*));
+    count = 0;
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node))
+    {
+        formulas[count++] = node->formula;
+    }
+
+    truth_table_build(table, factory, formulas, count);
+    free(formulas);
+}
+
+/*
+ * Frees the program of a truth table.
+ */
+void truth_table_destroy(truth_table* table)
+{
+    free(table->instructions);
+    free(table->propositions);
+    table->instructions = NULL;
+    table->propositions = NULL;
+    table->size = 0;
+    table->variables = 0;
+    table->registers = 0;
+}
+
+/*
+ * Runs the program on the block of valuations in the variable registers. The loops over the lanes have a constant
+ * trip count, so the compiler can turn each instruction into a few vector operations.
+ */
+static void truth_table_run(const truth_table* table, uint64_t* words)
+{
+    for (size_t i = 0; i < table->size; ++i)
+    {
+        const truth_table_instruction* instruction = &table->instructions[i];
+        uint64_t* target = words + (size_t)instruction->target * TRUTH_TABLE_LANES;
+        const uint64_t* left = words + (size_t)instruction->left * TRUTH_TABLE_LANES;
+        const uint64_t* right = words + (size_t)instruction->right * TRUTH_TABLE_LANES;
+
+        switch (instruction->opcode)
+        {
+            case table_true:
+                for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { target[lane] = ~0ULL; }
+                break;
+            case table_not:
+                for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { target[lane] = ~left[lane]; }
+                break;
+            case table_and:
+                for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { target[lane] = left[lane] & right[lane]; }
+                break;
+            case table_or:
+                for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { target[lane] = left[lane] | right[lane]; }
+                break;
+            default:
+                for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { target[lane] = ~left[lane] | right[lane]; }
+                break;
+        }
+    }
+}
+
+/*
+ * Sweeps the valuations of the variables of a truth table in blocks within the limits (none if NULL), where the
+ * expansion limit bounds the number of blocks, and frees the table. Returns whether the compiled formula is
+ * satisfiable, storing the values of its first model in the valuation if it is not NULL. If models is NULL the sweep
+ * stops at the first model; otherwise it covers every valuation and stores the number of models in models.
+ * Formulas with more than TRUTH_TABLE_MAX_VARIABLES propositions, and sweeps stopped by a limit before the answer is
+ * known, are unknown.
+ */
+prover_result truth_table_prove(truth_table* table, const prover_limits* limits, bool* valuation, uint64_t* models,
+                                prover_stats* stats)
+{
+    if (table->variables > TRUTH_TABLE_MAX_VARIABLES)
+    {
+        truth_table_destroy(table);
+        return result_unknown;
+    }
+
+    size_t bytes = table->registers * TRUTH_TABLE_LANES * sizeof(uint64_t) +
+                   table->size * sizeof(truth_table_instruction) + table->variables * sizeof(int);
+    uint64_t* words = (uint64_t*)malloc((table->registers + 1) * TRUTH_TABLE_LANES * sizeof(uint64_t));
+
+    // The variables below TRUTH_TABLE_BLOCK_BITS take every combination of values within a block: the first six within
+    // a word and the others across the lanes. The remaining variables are the bits of the block number.
+    for (size_t v = 0; v < table->variables && v < TRUTH_TABLE_BLOCK_BITS; ++v)
+    {
+        for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane)
+        {
+            words[v * TRUTH_TABLE_LANES + lane] = v < 6 ? truth_table_patterns[v] : ((lane >> (v - 6)) & 1 ? ~0ULL : 0);
+        }
+    }
+
+    // With fewer variables than the block bits the block repeats the valuations, so only the first ones are counted.
+    uint64_t mask[TRUTH_TABLE_LANES];
+    uint64_t valuations = (uint64_t)1 << (table->variables < TRUTH_TABLE_BLOCK_BITS ? table->variables
+                                                                            : TRUTH_TABLE_BLOCK_BITS);
+    for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane)
+    {
+        uint64_t first = (uint64_t)lane * 64;
+        uint64_t bits = valuations > first ? valuations - first : 0;
+        mask[lane] = bits >= 64 ? ~0ULL : ((uint64_t)1 << bits) - 1;
+    }
+
+    uint64_t blocks = 1;
+    if (table->variables > TRUTH_TABLE_BLOCK_BITS) { blocks <<= table->variables - TRUTH_TABLE_BLOCK_BITS; }
+
+    budget budget;
+    budget_init(&budget, limits, 1);
+
+    bool found = false;
+    bool stopped = false;
+    uint64_t first = 0;
+    uint64_t count = 0;
+    const uint64_t* result = words + (size_t)table->result * TRUTH_TABLE_LANES;
+    for (uint64_t block = 0; block < blocks; ++block)
+    {
+        if (budget_exhausted(&budget, (long)block, bytes))
+        {
+            stopped = true;
+            break;
+        }
+
+        for (size_t v = TRUTH_TABLE_BLOCK_BITS; v < table->variables; ++v)
+        {
+            uint64_t value = (block >> (v - TRUTH_TABLE_BLOCK_BITS)) & 1 ? ~0ULL : 0;
+            for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane) { words[v * TRUTH_TABLE_LANES + lane] = value; }
+        }
+
+        truth_table_run(table, words);
+
+        for (int lane = 0; lane < TRUTH_TABLE_LANES; ++lane)
+        {
+            uint64_t word = (table->negated ? ~result[lane] : result[lane]) & mask[lane];
+            if (word != 0 && !found)
+            {
+                found = true;
+                first = (block << TRUTH_TABLE_BLOCK_BITS) | ((uint64_t)lane << 6) | (uint64_t)__builtin_ctzll(word);
+            }
+
+            count += (uint64_t)__builtin_popcountll(word);
+        }
+
+        if (found && models == NULL) { break; } // the first model decides satisfiability.
+    }
+
+    if (found && valuation != NULL)
+    {
+        for (size_t v = 0; v < table->variables; ++v) { valuation[table->propositions[v]] = (first >> v) & 1; }
+    }
+
+    if (models != NULL) { *models = count; }
+
+    if (stats != NULL)
+    {
+        stats->peak_bytes = bytes;
+        stats->total_bytes = bytes;
+    }
+
+    free(words);
+    truth_table_destroy(table);
+    if (stopped && (models != NULL || !found)) { return result_unknown; }
+    return found ? result_true : result_false;
+}
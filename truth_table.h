@@ -0,0 +1,67 @@
+#ifndef THEOREMPROVER_TRUTH_TABLE_H
+#define THEOREMPROVER_TRUTH_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "factory.h"
+#include "theory.h"
+#include "budget.h"
+#include "prover.h"
+
+#define TRUTH_TABLE_LANES 4             // words of a register: a block of 4 * 64 = 256 valuations.
+#define TRUTH_TABLE_MAX_VARIABLES 62    // largest number of propositions whose valuations can be counted.
+
+/*
+ * Truth table operations of the straight-line program.
+ */
+typedef enum truth_table_opcode
+{
+    table_true,     // target = 1 (the conjunction of an empty theory).
+    table_not,      // target = -left
+    table_and,      // target = left ^ right
+    table_or,       // target = left v right
+    table_implies   // target = left > right
+} truth_table_opcode;
+
+/*
+ * Truth table instruction computes the values of one subformula in a block of valuations from the registers of its
+ * operands.
+ */
+typedef struct truth_table_instruction
+{
+    truth_table_opcode opcode;
+    uint32_t target;
+    uint32_t left;
+    uint32_t right;
+} truth_table_instruction;
+
+/*
+ * Truth table is a formula compiled into a straight-line program over registers of TRUTH_TABLE_LANES words, where
+ * every bit holds the value of a subformula under one valuation. The first registers are the propositions (the
+ * variables) and every other register is written by one instruction, in an order that computes the operands of a
+ * subformula before the subformula. Running the program once evaluates the formula under a block of 256 valuations
+ * with a few bitwise operations per subformula, so a sweep over the blocks decides satisfiability and validity and
+ * counts the models without branching.
+ */
+typedef struct truth_table
+{
+    truth_table_instruction* instructions;
+    size_t size;            // number of instructions.
+    int* propositions;      // proposition id of each variable.
+    size_t variables;       // number of variables.
+    size_t registers;       // number of registers (variables and instruction targets).
+    uint32_t result;        // register of the formula (the conjunction of the formulas of a theory).
+    bool negated;           // the program tests the negation of the result.
+} truth_table;
+
+void truth_table_compile(truth_table* table, formula_factory* factory, tree_node* formula, bool negated);
+
+void truth_table_compile_theory(truth_table* table, formula_factory* factory, theory* theory);
+
+void truth_table_destroy(truth_table* table);
+
+prover_result truth_table_prove(truth_table* table, const prover_limits* limits, bool* valuation, uint64_t* models,
+                                prover_stats* stats);
+
+#endif //THEOREMPROVER_TRUTH_TABLE_H
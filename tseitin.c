@@ -0,0 +1,312 @@
+#include "tseitin.h"
+#include "tokenizer.h"
+#include "symbol_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const cdcl_literal no_guard = (cdcl_literal)-1; // marks clauses asserted without a gate variable.
+
+/*
+ * Initializes an encoder that adds the formulas of the factory to the solver.
+ */
+void tseitin_init(tseitin_encoder* encoder, formula_factory* factory, cdcl_solver* solver)
+{
+    encoder->factory = factory;
+    encoder->solver = solver;
+    nnf_init(&encoder->converter, factory);
+    encoder->proposition_vars = NULL;
+    encoder->proposition_capacity = 0;
+    encoder->node_vars = NULL;
+    encoder->parents = NULL;
+    encoder->counted = NULL;
+    encoder->node_capacity = 0;
+    encoder->clause = NULL;
+    encoder->clause_size = 0;
+    encoder->clause_capacity = 0;
+    stack_init(&encoder->pending);
+    stack_init(&encoder->leaves);
+    stack_init(&encoder->conjuncts);
+}
+
+/*
+ * Frees the maps and buffers of the encoder (the solver and the formulas are owned by the caller).
+ */
+void tseitin_destroy(tseitin_encoder* encoder)
+{
+    nnf_destroy(&encoder->converter);
+    free(encoder->proposition_vars);
+    free(encoder->node_vars);
+    free(encoder->parents);
+    free(encoder->counted);
+    free(encoder->clause);
+    stack_destroy(&encoder->pending);
+    stack_destroy(&encoder->leaves);
+    stack_destroy(&encoder->conjuncts);
+}
+
+/*
+ * Grows the per-node arrays to cover every node of the factory.
+ */
+static void tseitin_reserve_nodes(tseitin_encoder* encoder)
+{
+    size_t count = encoder->factory->size;
+    if (count <= encoder->node_capacity) { return; }
+
+    size_t capacity = encoder->node_capacity == 0 ? 256 : encoder->node_capacity;
+    while (capacity < count) { capacity *= 2; }
+
+    encoder->node_vars = (int*)realloc(encoder->node_vars, capacity * sizeof(int));
+    encoder->parents = (unsigned char*)realloc(encoder->parents, capacity * sizeof(unsigned char));
+    encoder->counted = (bool*)realloc(encoder->counted, capacity * sizeof(bool));
+
+    size_t added = capacity - encoder->node_capacity;
+    memset(encoder->node_vars + encoder->node_capacity, 0xff, added * sizeof(int));
+    memset(encoder->parents + encoder->node_capacity, 0, added * sizeof(unsigned char));
+    memset(encoder->counted + encoder->node_capacity, 0, added * sizeof(bool));
+    encoder->node_capacity = capacity;
+}
+
+/*
+ * Gets the solver variable of a proposition id, creating it on first use.
+ */
+int tseitin_proposition_var(tseitin_encoder* encoder, int id)
+{
+    if ((size_t)id >= encoder->proposition_capacity)
+    {
+        size_t capacity = encoder->proposition_capacity == 0 ? 64 : encoder->proposition_capacity;
+        while (capacity <= (size_t)id) { capacity *= 2; }
+
+        encoder->proposition_vars = (int*)realloc(encoder->proposition_vars, capacity * sizeof(int));
+        memset(encoder->proposition_vars + encoder->proposition_capacity, 0xff,
+               (capacity - encoder->proposition_capacity) * sizeof(int));
+        encoder->proposition_capacity = capacity;
+    }
+
+    if (encoder->proposition_vars[id] < 0)
+    {
+        encoder->proposition_vars[id] = cdcl_new_var(encoder->solver);
+    }
+
+    return encoder->proposition_vars[id];
+}
+
+/*
+ * Checks if a formula in negation normal form is a conjunction (otherwise a non-literal is a disjunction).
+ */
+static inline bool tseitin_is_conjunction(tree_node* formula)
+{
+    return formula->token.type == binary_connective && is_and_connective(formula->token.symbol);
+}
+
+/*
+ * Checks if a subformula with the same connective as its parent can be flattened into the parent: it is only used
+ * by one parent and has no gate variable, so its operands can be added to the parent directly.
+ */
+static inline bool tseitin_flattens(tseitin_encoder* encoder, tree_node* formula, bool conjunction)
+{
+    return formula->token.type == binary_connective && tseitin_is_conjunction(formula) == conjunction &&
+           encoder->parents[formula->index] <= 1 && encoder->node_vars[formula->index] < 0;
+}
+
+/*
+ * Counts the parents of the subformulas of a formula that have not been counted yet.
+ */
+static void tseitin_count(tseitin_encoder* encoder, tree_node* formula)
+{
+    tseitin_reserve_nodes(encoder);
+    stack_push(&encoder->leaves, formula);
+
+    while (!stack_empty(&encoder->leaves))
+    {
+        tree_node* node = (tree_node*)stack_pop(&encoder->leaves);
+        if (node->token.type != binary_connective || encoder->counted[node->index]) { continue; }
+
+        encoder->counted[node->index] = true;
+        tree_node* children[2] = { node->left_child, node->right_child };
+        for (int i = 0; i < 2; ++i)
+        {
+            if (encoder->parents[children[i]->index] < 2) { ++encoder->parents[children[i]->index]; }
+            stack_push(&encoder->leaves, children[i]);
+        }
+    }
+}
+
+/*
+ * Gets the solver literal of a literal or of the gate variable of a non-literal (creating the gate on first use).
+ */
+static cdcl_literal tseitin_literal(tseitin_encoder* encoder, tree_node* formula)
+{
+    if (formula->token.type == proposition)
+    {
+        return cdcl_lit(tseitin_proposition_var(encoder, formula->token.id), false);
+    }
+    else if (formula->token.type == negation)
+    {
+        return cdcl_lit(tseitin_proposition_var(encoder, formula->left_child->token.id), true);
+    }
+
+    int* variable = &encoder->node_vars[formula->index];
+    if (*variable < 0)
+    {
+        *variable = cdcl_new_var(encoder->solver);
+        stack_push(&encoder->pending, formula);
+    }
+
+    return cdcl_lit(*variable, false);
+}
+
+/*
+ * Appends a literal to the clause under construction.
+ */
+static void tseitin_clause_push(tseitin_encoder* encoder, cdcl_literal literal)
+{
+    if (encoder->clause_size == encoder->clause_capacity)
+    {
+        encoder->clause_capacity = encoder->clause_capacity == 0 ? 16 : 2 * encoder->clause_capacity;
+        encoder->clause = (cdcl_literal*)realloc(encoder->clause, encoder->clause_capacity * sizeof(cdcl_literal));
+    }
+
+    encoder->clause[encoder->clause_size++] = literal;
+}
+
+/*
+ * Adds the clause (guard v d1 v ... v dn) for a disjunction, where d1, ..., dn are the operands of the disjunction
+ * after flattening nested disjunctions (conjunctions among them are replaced by their gate literals).
+ */
+static void tseitin_disjunction(tseitin_encoder* encoder, tree_node* formula, cdcl_literal guard)
+{
+    encoder->clause_size = 0;
+    if (guard != no_guard) { tseitin_clause_push(encoder, guard); }
+
+    stack_push(&encoder->leaves, formula->right_child);
+    stack_push(&encoder->leaves, formula->left_child);
+
+    while (!stack_empty(&encoder->leaves))
+    {
+        tree_node* node = (tree_node*)stack_pop(&encoder->leaves);
+        if (tseitin_flattens(encoder, node, false))
+        {
+            stack_push(&encoder->leaves, node->right_child);
+            stack_push(&encoder->leaves, node->left_child);
+        }
+        else
+        {
+            tseitin_clause_push(encoder, tseitin_literal(encoder, node));
+        }
+    }
+
+    cdcl_add_clause(encoder->solver, encoder->clause, encoder->clause_size);
+}
+
+/*
+ * Adds the clauses (guard v c) for every operand c of a conjunction after flattening nested conjunctions. Operands that
+ * are unshared disjunctions become clauses of their own instead of gates.
+ */
+static void tseitin_conjunction(tseitin_encoder* encoder, tree_node* formula, cdcl_literal guard)
+{
+    stack_push(&encoder->conjuncts, formula->right_child);
+    stack_push(&encoder->conjuncts, formula->left_child);
+
+    while (!stack_empty(&encoder->conjuncts))
+    {
+        tree_node* node = (tree_node*)stack_pop(&encoder->conjuncts);
+        if (tseitin_flattens(encoder, node, true))
+        {
+            stack_push(&encoder->conjuncts, node->right_child);
+            stack_push(&encoder->conjuncts, node->left_child);
+        }
+        else if (tseitin_flattens(encoder, node, false))
+        {
+            tseitin_disjunction(encoder, node, guard);
+        }
+        else
+        {
+            cdcl_literal clause[2] = { guard, tseitin_literal(encoder, node) };
+            if (guard == no_guard)
+            {
+                cdcl_add_clause(encoder->solver, clause + 1, 1);
+            }
+            else
+            {
+                cdcl_add_clause(encoder->solver, clause, 2);
+            }
+        }
+    }
+}
+
+/*
+ * Adds the clauses of a formula in negation normal form guarded by a literal (or asserted if there is no guard).
+ */
+static void tseitin_encode(tseitin_encoder* encoder, tree_node* formula, cdcl_literal guard)
+{
+    if (formula->token.type != binary_connective)
+    {
+        cdcl_literal clause[2] = { guard, tseitin_literal(encoder, formula) };
+        cdcl_add_clause(encoder->solver, guard == no_guard ? clause + 1 : clause, guard == no_guard ? 1 : 2);
+    }
+    else if (tseitin_is_conjunction(formula))
+    {
+        tseitin_conjunction(encoder, formula, guard);
+    }
+    else
+    {
+        tseitin_disjunction(encoder, formula, guard);
+    }
+}
+
+/*
+ * Adds the defining clauses (gate -> subformula) of every pending gate.
+ */
+static void tseitin_define_pending(tseitin_encoder* encoder)
+{
+    while (!stack_empty(&encoder->pending))
+    {
+        tree_node* gate = (tree_node*)stack_pop(&encoder->pending);
+        cdcl_literal guard = cdcl_lit(encoder->node_vars[gate->index], true);
+        tseitin_encode(encoder, gate, guard);
+    }
+}
+
+/*
+ * Asserts a formula (or its negation if negated is set): the clauses added to the solver are satisfiable together
+ * with the other asserted formulas if and only if the formulas are.
+ */
+void tseitin_assert(tseitin_encoder* encoder, tree_node* formula, bool negated)
+{
+    tree_node* nnf = nnf_convert(&encoder->converter, formula, negated);
+    tseitin_count(encoder, nnf);
+    tseitin_encode(encoder, nnf, no_guard);
+    tseitin_define_pending(encoder);
+}
+
+/*
+ * Asserts a formula under a guard literal: every clause of the formula contains the guard, so the formula only holds in
+ * the assignments in which the guard is false. Assuming the negation of the guard enables the formula and adding the
+ * guard as a unit clause disables it for good, while the gates of its subformulas can still be shared.
+ */
+void tseitin_assert_guarded(tseitin_encoder* encoder, tree_node* formula, cdcl_literal guard)
+{
+    tree_node* nnf = nnf_convert(&encoder->converter, formula, false);
+    tseitin_count(encoder, nnf);
+    tseitin_encode(encoder, nnf, guard);
+    tseitin_define_pending(encoder);
+}
+
+/*
+ * Asserts every formula of a theory. The parents of all formulas are counted before encoding, so subformulas shared
+ * between formulas of the theory get a single gate.
+ */
+void tseitin_assert_theory(tseitin_encoder* encoder, theory* theory)
+{
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node))
+    {
+        tseitin_count(encoder, nnf_convert(&encoder->converter, node->formula, false));
+    }
+
+    for (theory_node* node = theory_first(theory); node != NULL; node = theory_next(theory, node))
+    {
+        tseitin_encode(encoder, nnf_convert(&encoder->converter, node->formula, false), no_guard);
+        tseitin_define_pending(encoder);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef THEOREMPROVER_TSEITIN_H
+#define THEOREMPROVER_TSEITIN_H
+
+#include <stdbool.h>
+#include "cdcl.h"
+#include "nnf.h"
+#include "stack.h"
+
+/*
+ * Tseitin encoder adds formulas of a factory to a CDCL solver as clauses. Formulas are first converted into negation
+ * normal form, so every subformula occurs positively and each gate variable only needs the clauses of one direction
+ * (gate -> subformula). Nested conjunctions and disjunctions that are not shared are flattened into their parent, so a
+ * disjunction of literals becomes a single clause, and shared subformulas get one gate variable each.
+ */
+typedef struct tseitin_encoder
+{
+    formula_factory* factory;
+    cdcl_solver* solver;
+    nnf_converter converter;
+    int* proposition_vars;      // solver variable of each proposition id (-1 if not yet used).
+    size_t proposition_capacity;
+    int* node_vars;             // gate variable of each factory node (-1 if the node has no gate).
+    unsigned char* parents;     // number of parents of each node seen so far (saturated at 2).
+    bool* counted;              // marks the nodes whose children have been counted.
+    size_t node_capacity;
+    cdcl_literal* clause;       // clause under construction.
+    size_t clause_size;
+    size_t clause_capacity;
+    stack pending;              // gates that have a variable but no defining clauses yet.
+    stack leaves;               // explicit stacks of the flattening traversals.
+    stack conjuncts;
+} tseitin_encoder;
+
+void tseitin_init(tseitin_encoder* encoder, formula_factory* factory, cdcl_solver* solver);
+
+void tseitin_destroy(tseitin_encoder* encoder);
+
+void tseitin_assert(tseitin_encoder* encoder, tree_node* formula, bool negated);
+
+void tseitin_assert_guarded(tseitin_encoder* encoder, tree_node* formula, cdcl_literal guard);
+
+void tseitin_assert_theory(tseitin_encoder* encoder, theory* theory);
+
+int tseitin_proposition_var(tseitin_encoder* encoder, int id);
+
+#endif //THEOREMPROVER_TSEITIN_H